@@ -1,534 +1,3224 @@
 #include "big_integer.h"
 
 #include <algorithm>
-#include <charconv>
+#include <array>
+#include <bit>
 #include <climits>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <deque>
+#include <functional>
 #include <limits>
+#include <memory>
+#include <memory_resource>
+#include <numeric>
 #include <ostream>
+#include <random>
 #include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace {
+constexpr size_t KARATSUBA_THRESHOLD = 32;
+constexpr size_t SQR_KARATSUBA_THRESHOLD = 48;
+constexpr size_t TOOM3_THRESHOLD = 250;
+constexpr size_t TOOM4_THRESHOLD = 1200;
+constexpr size_t SQR_TOOM3_THRESHOLD = 200;
+constexpr size_t SQR_TOOM4_THRESHOLD = 600;
+constexpr size_t NTT_THRESHOLD = 12000;
+constexpr size_t NTT_MAX_SIZE = size_t(1) << 26;
+// Root tables for transforms up to this length are kept per thread, one per NTT prime and direction (6 MB at most);
+// longer transforms compute their roots for each product.
+constexpr size_t NTT_ROOT_CACHE_SIZE = size_t(1) << 18;
+constexpr size_t DIVISION_THRESHOLD = 48;
+constexpr size_t NEWTON_DIVISION_THRESHOLD = 40000;
+constexpr size_t RECIPROCAL_THRESHOLD_BITS = 32 * 200;
+static_assert(RECIPROCAL_THRESHOLD_BITS / 32 < NEWTON_DIVISION_THRESHOLD);
+constexpr size_t TO_STRING_THRESHOLD = 20;
+constexpr size_t FROM_STRING_THRESHOLD = 40;
+constexpr uint32_t DECIMAL_CHUNK_BASE = 1000000000;
+
+#if defined(__SIZEOF_INT128__) && !defined(BIGINT_NO_INT128)
+#define BIGINT_WIDE_KERNELS
+// Linear kernels step over pairs of limbs as 64-bit words; odd tails fall through to the 32-bit loops.
+__extension__ typedef unsigned __int128 uint128_t;
+
+uint64_t loadWord(const uint32_t* p) {
+  return p[0] | static_cast<uint64_t>(p[1]) << 32;
+}
+
+void storeWord(uint32_t* p, uint64_t value) {
+  p[0] = static_cast<uint32_t>(value);
+  p[1] = static_cast<uint32_t>(value >> 32);
+}
+#endif
+
+uint32_t addTo(uint32_t* acc, size_t acc_size, const uint32_t* b, size_t b_size) {
+  uint32_t carry = 0;
+  size_t i = 0;
+#ifdef BIGINT_WIDE_KERNELS
+  for (; i + 1 < b_size; i += 2) {
+    uint128_t cur = static_cast<uint128_t>(loadWord(acc + i)) + loadWord(b + i) + carry;
+    storeWord(acc + i, static_cast<uint64_t>(cur));
+    carry = static_cast<uint32_t>(cur >> 64);
+  }
+#endif
+  for (; i < b_size; i++) {
+    uint64_t cur = static_cast<uint64_t>(acc[i]) + b[i] + carry;
+    acc[i] = static_cast<uint32_t>(cur);
+    carry = static_cast<uint32_t>(cur >> 32);
+  }
+  for (; carry != 0 && i < acc_size; i++) {
+    carry = ++acc[i] == 0;
+  }
+  return carry;
+}
+
+uint32_t subFrom(uint32_t* acc, size_t acc_size, const uint32_t* b, size_t b_size) {
+  uint32_t borrow = 0;
+  size_t i = 0;
+#ifdef BIGINT_WIDE_KERNELS
+  for (; i + 1 < b_size; i += 2) {
+    uint128_t cur = static_cast<uint128_t>(loadWord(acc + i)) - loadWord(b + i) - borrow;
+    storeWord(acc + i, static_cast<uint64_t>(cur));
+    borrow = static_cast<uint32_t>(cur >> 127);
+  }
+#endif
+  for (; i < b_size; i++) {
+    uint64_t cur = static_cast<uint64_t>(acc[i]) - b[i] - borrow;
+    acc[i] = static_cast<uint32_t>(cur);
+    borrow = static_cast<uint32_t>(cur >> 63);
+  }
+  for (; borrow != 0 && i < acc_size; i++) {
+    borrow = acc[i]-- == 0;
+  }
+  return borrow;
+}
+
+uint32_t decrementLimbs(uint32_t* a, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    if (a[i]-- != 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+uint32_t incrementLimbs(uint32_t* a, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    if (++a[i] != 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+uint32_t addLimbs(uint32_t* res, const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size) {
+  std::copy_n(a, a_size, res);
+  return addTo(res, a_size, b, b_size);
+}
+
+uint32_t subLimbs(uint32_t* res, const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size) {
+  uint32_t borrow = 0;
+  size_t i = 0;
+#ifdef BIGINT_WIDE_KERNELS
+  for (; i + 1 < b_size; i += 2) {
+    uint128_t cur = static_cast<uint128_t>(loadWord(a + i)) - loadWord(b + i) - borrow;
+    storeWord(res + i, static_cast<uint64_t>(cur));
+    borrow = static_cast<uint32_t>(cur >> 127);
+  }
+#endif
+  for (; i < b_size; i++) {
+    uint64_t cur = static_cast<uint64_t>(a[i]) - b[i] - borrow;
+    res[i] = static_cast<uint32_t>(cur);
+    borrow = static_cast<uint32_t>(cur >> 63);
+  }
+  for (; i < a_size; i++) {
+    uint32_t cur = a[i];
+    res[i] = cur - borrow;
+    borrow &= cur == 0;
+  }
+  return borrow;
+}
+
+// Two's complement negation in place; returns 1 unless a was zero.
+uint32_t negateLimbs(uint32_t* a, size_t size) {
+  uint32_t borrow = 0;
+  for (size_t i = 0; i < size; i++) {
+    uint32_t limb = a[i];
+    a[i] = 0 - limb - borrow;
+    borrow |= limb != 0;
+  }
+  return borrow;
+}
+
+// op over the two's complement forms of a and b, which are magnitudes with the given signs. A negative operand is
+// negated as it streams: ~limb + carry, where the carry survives only through its low zero limbs and the
+// zero-extension beyond its length turns into ones. A negative result is turned back into a magnitude the same way,
+// so everything takes one pass.
+template <bool ANegative, bool BNegative, class Op>
+void bitwiseLimbs(uint32_t* res, size_t size, const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size,
+                  Op op) {
+  constexpr bool res_negative = op(ANegative, BNegative);
+  if constexpr (!ANegative && !BNegative) {
+    size_t common = std::min({size, a_size, b_size});
+    for (size_t i = 0; i < common; i++) {
+      res[i] = op(a[i], b[i]);
+    }
+    for (size_t i = common; i < size; i++) {
+      res[i] = op(i < a_size ? a[i] : 0, i < b_size ? b[i] : 0);
+    }
+  } else {
+    uint32_t a_carry = 1;
+    uint32_t b_carry = 1;
+    uint32_t res_carry = 1;
+    for (size_t i = 0; i < size; i++) {
+      uint32_t x = i < a_size ? a[i] : 0;
+      uint32_t y = i < b_size ? b[i] : 0;
+      if constexpr (ANegative) {
+        uint32_t limb = x;
+        x = ~limb + a_carry;
+        a_carry &= limb == 0;
+      }
+      if constexpr (BNegative) {
+        uint32_t limb = y;
+        y = ~limb + b_carry;
+        b_carry &= limb == 0;
+      }
+      uint32_t r = op(x, y);
+      if constexpr (res_negative) {
+        res[i] = ~r + res_carry;
+        res_carry &= r == 0;
+      } else {
+        res[i] = r;
+      }
+    }
+  }
+}
+
+size_t significantSize(const uint32_t* a, size_t size) {
+  while (size > 0 && a[size - 1] == 0) {
+    size--;
+  }
+  return size;
+}
+
+int compareLimbs(const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size) {
+  if (a_size != b_size) {
+    return a_size < b_size ? -1 : 1;
+  }
+  for (size_t i = a_size; i-- > 0;) {
+    if (a[i] != b[i]) {
+      return a[i] < b[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+uint32_t mulDigit(uint32_t* res, const uint32_t* a, size_t size, uint32_t b) {
+  uint32_t carry = 0;
+  size_t i = 0;
+#ifdef BIGINT_WIDE_KERNELS
+  for (; i + 1 < size; i += 2) {
+    uint128_t cur = static_cast<uint128_t>(loadWord(a + i)) * b + carry;
+    storeWord(res + i, static_cast<uint64_t>(cur));
+    carry = static_cast<uint32_t>(cur >> 64);
+  }
+#endif
+  for (; i < size; i++) {
+    uint64_t cur = static_cast<uint64_t>(a[i]) * b + carry;
+    res[i] = static_cast<uint32_t>(cur);
+    carry = static_cast<uint32_t>(cur >> 32);
+  }
+  return carry;
+}
+
+uint32_t subMulDigit(uint32_t* acc, const uint32_t* a, size_t size, uint32_t b) {
+  uint32_t borrow = 0;
+  size_t i = 0;
+#ifdef BIGINT_WIDE_KERNELS
+  for (; i + 1 < size; i += 2) {
+    uint128_t product = static_cast<uint128_t>(loadWord(a + i)) * b + borrow;
+    uint64_t low = static_cast<uint64_t>(product);
+    uint64_t cur = loadWord(acc + i);
+    borrow = static_cast<uint32_t>(product >> 64) + (cur < low);
+    storeWord(acc + i, cur - low);
+  }
+#endif
+  for (; i < size; i++) {
+    uint64_t product = static_cast<uint64_t>(a[i]) * b + borrow;
+    uint32_t low = static_cast<uint32_t>(product);
+    borrow = static_cast<uint32_t>(product >> 32) + (acc[i] < low);
+    acc[i] -= low;
+  }
+  return borrow;
+}
+
+// 0 <= shift < 32, res may coincide with a; returns the bits shifted out of the top limb.
+uint32_t shiftLeftLimbs(uint32_t* res, const uint32_t* a, size_t size, int shift) {
+  if (shift == 0) {
+    std::copy_backward(a, a + size, res + size);
+    return 0;
+  }
+  uint32_t out = size != 0 ? a[size - 1] >> (32 - shift) : 0;
+  for (size_t i = size; i-- > 1;) {
+    res[i] = (a[i] << shift) | (a[i - 1] >> (32 - shift));
+  }
+  if (size != 0) {
+    res[0] = a[0] << shift;
+  }
+  return out;
+}
+
+// 0 <= shift < 32, res may coincide with a; returns the bits shifted out of the bottom limb.
+uint32_t shiftRightLimbs(uint32_t* res, const uint32_t* a, size_t size, int shift) {
+  if (shift == 0) {
+    std::copy(a, a + size, res);
+    return 0;
+  }
+  uint32_t out = size != 0 ? a[0] << (32 - shift) : 0;
+  for (size_t i = 0; i + 1 < size; i++) {
+    res[i] = (a[i] >> shift) | (a[i + 1] << (32 - shift));
+  }
+  if (size != 0) {
+    res[size - 1] = a[size - 1] >> shift;
+  }
+  return out;
+}
+
+uint32_t addMulDigit(uint32_t* acc, const uint32_t* a, size_t size, uint32_t b) {
+  uint32_t carry = 0;
+  size_t i = 0;
+#ifdef BIGINT_WIDE_KERNELS
+  for (; i + 1 < size; i += 2) {
+    uint128_t cur = static_cast<uint128_t>(loadWord(a + i)) * b + loadWord(acc + i) + carry;
+    storeWord(acc + i, static_cast<uint64_t>(cur));
+    carry = static_cast<uint32_t>(cur >> 64);
+  }
+#endif
+  for (; i < size; i++) {
+    uint64_t cur = acc[i] + static_cast<uint64_t>(a[i]) * b + carry;
+    acc[i] = static_cast<uint32_t>(cur);
+    carry = static_cast<uint32_t>(cur >> 32);
+  }
+  return carry;
+}
+
+#ifdef BIGINT_WIDE_KERNELS
+// Adds a * b to acc[0..size) for a 64-bit b and returns the carry, which occupies the two limbs above.
+uint64_t addMulWord(uint32_t* acc, const uint32_t* a, size_t size, uint64_t b) {
+  uint64_t carry = 0;
+  size_t i = 0;
+  for (; i + 1 < size; i += 2) {
+    uint128_t cur = static_cast<uint128_t>(loadWord(a + i)) * b + loadWord(acc + i) + carry;
+    storeWord(acc + i, static_cast<uint64_t>(cur));
+    carry = static_cast<uint64_t>(cur >> 64);
+  }
+  if (i < size) {
+    uint128_t cur = static_cast<uint128_t>(a[i]) * b + acc[i] + carry;
+    acc[i] = static_cast<uint32_t>(cur);
+    carry = static_cast<uint64_t>(cur >> 32);
+  }
+  return carry;
+}
+
+uint64_t subMulWord(uint32_t* acc, const uint32_t* a, size_t size, uint64_t b) {
+  uint64_t borrow = 0;
+  size_t i = 0;
+  for (; i + 1 < size; i += 2) {
+    uint128_t product = static_cast<uint128_t>(loadWord(a + i)) * b + borrow;
+    uint64_t low = static_cast<uint64_t>(product);
+    uint64_t cur = loadWord(acc + i);
+    borrow = static_cast<uint64_t>(product >> 64) + (cur < low);
+    storeWord(acc + i, cur - low);
+  }
+  if (i < size) {
+    uint128_t product = static_cast<uint128_t>(a[i]) * b + borrow;
+    uint32_t low = static_cast<uint32_t>(product);
+    borrow = static_cast<uint64_t>(product >> 32) + (acc[i] < low);
+    acc[i] -= low;
+  }
+  return borrow;
+}
+
+void schoolbookMul(uint32_t* res, const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size) {
+  std::fill_n(res, a_size + b_size, 0);
+  size_t i = 0;
+  for (; i + 1 < a_size; i += 2) {
+    storeWord(res + i + b_size, addMulWord(res + i, b, b_size, loadWord(a + i)));
+  }
+  if (i < a_size) {
+    res[i + b_size] = addMulDigit(res + i, b, b_size, a[i]);
+  }
+}
+
+// Every cross product of distinct words is computed once and doubled, then the squares of the words are added.
+// An odd top limb contributes one extra row and square.
+void schoolbookSqr(uint32_t* res, const uint32_t* a, size_t size) {
+  size_t even = size & ~size_t(1);
+  std::fill_n(res, 2 * size, 0);
+  for (size_t i = 0; i + 2 < even; i += 2) {
+    storeWord(res + i + even, addMulWord(res + 2 * i + 2, a + i + 2, even - i - 2, loadWord(a + i)));
+  }
+  if (even != size) {
+    res[2 * even] = addMulDigit(res + even, a, even, a[even]);
+  }
+  shiftLeftLimbs(res, res, 2 * size, 1);
+  uint64_t carry = 0;
+  for (size_t i = 0; i < even; i += 2) {
+    uint64_t word = loadWord(a + i);
+    uint128_t square = static_cast<uint128_t>(word) * word;
+    uint128_t low = static_cast<uint128_t>(loadWord(res + 2 * i)) + static_cast<uint64_t>(square) + carry;
+    uint128_t high =
+        static_cast<uint128_t>(loadWord(res + 2 * i + 2)) + static_cast<uint64_t>(square >> 64) + (low >> 64);
+    storeWord(res + 2 * i, static_cast<uint64_t>(low));
+    storeWord(res + 2 * i + 2, static_cast<uint64_t>(high));
+    carry = static_cast<uint64_t>(high >> 64);
+  }
+  if (even != size) {
+    storeWord(res + 2 * even, loadWord(res + 2 * even) + static_cast<uint64_t>(a[even]) * a[even] + carry);
+  }
+}
+#else
+void schoolbookMul(uint32_t* res, const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size) {
+  std::fill_n(res, a_size + b_size, 0);
+  for (size_t i = 0; i < a_size; i++) {
+    res[i + b_size] = addMulDigit(res + i, b, b_size, a[i]);
+  }
+}
+
+// Every cross product a[i] * a[j], i < j, is computed once and doubled, then the squares a[i]^2 are added.
+void schoolbookSqr(uint32_t* res, const uint32_t* a, size_t size) {
+  std::fill_n(res, 2 * size, 0);
+  for (size_t i = 0; i + 1 < size; i++) {
+    res[i + size] = addMulDigit(res + 2 * i + 1, a + i + 1, size - i - 1, a[i]);
+  }
+  shiftLeftLimbs(res, res, 2 * size, 1);
+  uint32_t carry = 0;
+  for (size_t i = 0; i < size; i++) {
+    uint64_t square = static_cast<uint64_t>(a[i]) * a[i];
+    uint64_t low = static_cast<uint64_t>(res[2 * i]) + static_cast<uint32_t>(square) + carry;
+    uint64_t high = static_cast<uint64_t>(res[2 * i + 1]) + (square >> 32) + (low >> 32);
+    res[2 * i] = static_cast<uint32_t>(low);
+    res[2 * i + 1] = static_cast<uint32_t>(high);
+    carry = static_cast<uint32_t>(high >> 32);
+  }
+}
+#endif
+
+// Per-thread LIFO stack of limbs for kernel temporaries. Blocks are kept between calls and merged into one once the
+// stack empties, so it settles at the high-water mark and steady-state arithmetic allocates nothing for scratch.
+class scratch_stack {
+public:
+  static scratch_stack& local() {
+    thread_local scratch_stack stack;
+    return stack;
+  }
+
+  struct mark {
+    size_t block;
+    size_t top;
+  };
+
+  mark position() const {
+    return {_block, _top};
+  }
+
+  uint32_t* push(size_t size) {
+    while (_block < _blocks.size() && _blocks[_block].size - _top < size) {
+      _block++;
+      _top = 0;
+    }
+    if (_block == _blocks.size()) {
+      size_t last = _blocks.empty() ? 0 : _blocks.back().size;
+      _blocks.push_back({std::make_unique<uint32_t[]>(std::max(size, 2 * last)), std::max(size, 2 * last)});
+    }
+    uint32_t* res = _blocks[_block].limbs.get() + _top;
+    _top += size;
+    return res;
+  }
+
+  void pop(mark to) {
+    _block = to.block;
+    _top = to.top;
+    if (_block == 0 && _top == 0 && _blocks.size() > 1) {
+      size_t total = 0;
+      for (const block& b : _blocks) {
+        total += b.size;
+      }
+      _blocks.clear();
+      _blocks.push_back({std::make_unique<uint32_t[]>(total), total});
+    }
+  }
+
+private:
+  struct block {
+    std::unique_ptr<uint32_t[]> limbs;
+    size_t size;
+  };
+
+  std::vector<block> _blocks;
+  size_t _block = 0;
+  size_t _top = 0;
+};
+
+// Zero-initialized (or copied) temporary limbs on the scratch stack, released in reverse order of creation.
+class scratch_buffer {
+public:
+  explicit scratch_buffer(size_t size)
+      : _stack(scratch_stack::local()), _mark(_stack.position()), _data(_stack.push(size)), _size(size) {
+    std::fill_n(_data, size, 0);
+  }
+
+  scratch_buffer(const uint32_t* first, const uint32_t* last)
+      : _stack(scratch_stack::local()), _mark(_stack.position()), _data(_stack.push(last - first)),
+        _size(last - first) {
+    std::copy(first, last, _data);
+  }
+
+  scratch_buffer(const scratch_buffer&) = delete;
+
+  scratch_buffer& operator=(const scratch_buffer&) = delete;
+
+  ~scratch_buffer() {
+    _stack.pop(_mark);
+  }
+
+  uint32_t* data() {
+    return _data;
+  }
+
+  size_t size() const {
+    return _size;
+  }
+
+  uint32_t& operator[](size_t index) {
+    return _data[index];
+  }
+
+  uint32_t* begin() {
+    return _data;
+  }
+
+  uint32_t* end() {
+    return _data + _size;
+  }
+
+  uint32_t& back() {
+    return _data[_size - 1];
+  }
+
+private:
+  scratch_stack& _stack;
+  scratch_stack::mark _mark;
+  uint32_t* _data;
+  size_t _size;
+};
+
+void mulLimbs(uint32_t* res, const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size);
+
+void sqrLimbs(uint32_t* res, const uint32_t* a, size_t size);
+
+// a_size >= b_size > (a_size + 1) / 2, so both halves of b are non-empty.
+void karatsubaMul(uint32_t* res, const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size) {
+  size_t half = (a_size + 1) / 2;
+  size_t res_size = a_size + b_size;
+  mulLimbs(res, a, half, b, half);
+  mulLimbs(res + 2 * half, a + half, a_size - half, b + half, b_size - half);
+
+  scratch_buffer a_sum(half + 1);
+  scratch_buffer b_sum(half + 1);
+  a_sum[half] = addLimbs(a_sum.data(), a, half, a + half, a_size - half);
+  b_sum[half] = addLimbs(b_sum.data(), b, half, b + half, b_size - half);
+  size_t a_sum_size = significantSize(a_sum.data(), half + 1);
+  size_t b_sum_size = significantSize(b_sum.data(), half + 1);
+
+  scratch_buffer middle(2 * half + 2);
+  mulLimbs(middle.data(), a_sum.data(), a_sum_size, b_sum.data(), b_sum_size);
+  subFrom(middle.data(), middle.size(), res, 2 * half);
+  subFrom(middle.data(), middle.size(), res + 2 * half, res_size - 2 * half);
+  addTo(res + half, res_size - half, middle.data(), significantSize(middle.data(), middle.size()));
+}
+
+// A signed value in a fixed slot of scratch storage. The slots of a Toom step are sized for the largest value the
+// step produces, so that the evaluation and interpolation sequences never allocate.
+struct signed_limbs {
+  uint32_t* digits = nullptr;
+  size_t size = 0;
+  bool negative = false;
+
+  void trim() {
+    size = significantSize(digits, size);
+    negative = negative && size != 0;
+  }
+};
+
+// Carves count slots of slot_size limbs out of one scratch buffer.
+class signed_slots {
+public:
+  signed_slots(size_t count, size_t slot_size) : _storage(count * slot_size), _slot_size(slot_size), _used(0) {}
+
+  signed_limbs next() {
+    return {_storage.data() + _slot_size * _used++};
+  }
+
+private:
+  scratch_buffer _storage;
+  size_t _slot_size;
+  size_t _used;
+};
+
+void setPiece(signed_limbs& dst, const uint32_t* a, size_t size, size_t index, size_t len) {
+  size_t begin = std::min(index * len, size);
+  size_t end = std::min(begin + len, size);
+  std::copy(a + begin, a + end, dst.digits);
+  dst.size = end - begin;
+  dst.negative = false;
+  dst.trim();
+}
+
+void assign(signed_limbs& dst, const signed_limbs& src) {
+  std::copy_n(src.digits, src.size, dst.digits);
+  dst.size = src.size;
+  dst.negative = src.negative;
+}
+
+void addSigned(signed_limbs& acc, const signed_limbs& b, bool subtract = false) {
+  bool b_negative = b.negative != subtract;
+  if (acc.negative == b_negative) {
+    size_t size = std::max(acc.size, b.size) + 1;
+    std::fill(acc.digits + acc.size, acc.digits + size, 0);
+    acc.size = size;
+    addTo(acc.digits, acc.size, b.digits, b.size);
+  } else if (compareLimbs(acc.digits, acc.size, b.digits, b.size) >= 0) {
+    subFrom(acc.digits, acc.size, b.digits, b.size);
+  } else {
+    subLimbs(acc.digits, b.digits, b.size, acc.digits, acc.size);
+    acc.size = b.size;
+    acc.negative = b_negative;
+  }
+  acc.trim();
+}
+
+// acc = b - acc.
+void subtractFrom(signed_limbs& acc, const signed_limbs& b) {
+  addSigned(acc, b, true);
+  acc.negative = !acc.negative && acc.size != 0;
+}
+
+void setSum(signed_limbs& dst, const signed_limbs& a, const signed_limbs& b, bool subtract = false) {
+  assign(dst, a);
+  addSigned(dst, b, subtract);
+}
+
+void scale(signed_limbs& a, uint32_t factor) {
+  a.digits[a.size] = mulDigit(a.digits, a.digits, a.size, factor);
+  a.size++;
+  a.trim();
+}
+
+// acc += factor * b, with tmp as room for the scaled b.
+void addScaled(signed_limbs& acc, const signed_limbs& b, uint32_t factor, signed_limbs& tmp, bool subtract = false) {
+  assign(tmp, b);
+  scale(tmp, factor);
+  addSigned(acc, tmp, subtract);
+}
+
+// Inverse of an odd a modulo 2^32 by Newton's iteration; a is its own inverse modulo 8 and every step doubles the
+// number of correct bits.
+constexpr uint32_t inverseLimb(uint32_t a) {
+  uint32_t inverse = a;
+  for (int i = 0; i < 4; i++) {
+    inverse *= 2 - a * inverse;
+  }
+  return inverse;
+}
+
+// Division by a small divisor that is known to divide a: trailing zero bits are shifted out and
+// the odd part is divided by multiplying with its inverse modulo 2^32 (Jebelean's exact division).
+void divExact(signed_limbs& a, uint32_t divisor) {
+  int shift = std::countr_zero(divisor);
+  divisor >>= shift;
+  shiftRightLimbs(a.digits, a.digits, a.size, shift);
+  if (divisor != 1) {
+    uint32_t inverse = inverseLimb(divisor);
+    uint32_t borrow = 0;
+    for (size_t i = 0; i < a.size; i++) {
+      uint32_t digit = a.digits[i];
+      uint32_t cur = digit - borrow;
+      uint32_t next_borrow = digit < borrow;
+      a.digits[i] = cur * inverse;
+      borrow = static_cast<uint32_t>((static_cast<uint64_t>(a.digits[i]) * divisor) >> 32) + next_borrow;
+    }
+  }
+  a.trim();
+}
+
+void mulSigned(signed_limbs& dst, const signed_limbs& a, const signed_limbs& b) {
+  dst.size = 0;
+  dst.negative = false;
+  if (a.size == 0 || b.size == 0) {
+    return;
+  }
+  dst.size = a.size + b.size;
+  dst.negative = a.negative != b.negative;
+  if (&a == &b) {
+    sqrLimbs(dst.digits, a.digits, a.size);
+  } else {
+    mulLimbs(dst.digits, a.digits, a.size, b.digits, b.size);
+  }
+  dst.trim();
+}
+
+void composeLimbs(uint32_t* res, size_t res_size, const signed_limbs* coefficients, size_t count, size_t len) {
+  std::fill_n(res, res_size, 0);
+  for (size_t i = 0; i < count; i++) {
+    addTo(res + i * len, res_size - i * len, coefficients[i].digits, coefficients[i].size);
+  }
+}
+
+// Toom-3 with evaluation points 0, 1, -1, -2, inf and Bodrato's interpolation sequence.
+void toom3Mul(uint32_t* res, const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size) {
+  size_t len = (a_size + 2) / 3;
+  signed_slots products(6, 2 * len + 6);
+  std::array<signed_limbs, 5> w;
+  for (signed_limbs& x : w) {
+    x = products.next();
+  }
+  signed_limbs tmp = products.next();
+  {
+    bool square = a == b && a_size == b_size;
+    signed_slots values(square ? 7 : 14, len + 3);
+    auto evaluate = [len, &values](const uint32_t* x, size_t x_size) {
+      std::array<signed_limbs, 5> u;
+      for (signed_limbs& y : u) {
+        y = values.next();
+      }
+      signed_limbs x1 = values.next();
+      signed_limbs even = values.next();
+      setPiece(u[0], x, x_size, 0, len);
+      setPiece(x1, x, x_size, 1, len);
+      setPiece(u[4], x, x_size, 2, len);
+      setSum(even, u[0], u[4]);
+      setSum(u[1], even, x1);
+      setSum(u[2], even, x1, true);
+      setSum(u[3], u[2], u[4]);
+      scale(u[3], 2);
+      addSigned(u[3], u[0], true);
+      return u;
+    };
+    std::array<signed_limbs, 5> u = evaluate(a, a_size);
+    std::array<signed_limbs, 5> v = square ? u : evaluate(b, b_size);
+    for (size_t i = 0; i < w.size(); i++) {
+      mulSigned(w[i], u[i], square ? u[i] : v[i]);
+    }
+  }
+
+  addSigned(w[3], w[1], true);
+  divExact(w[3], 3);
+  addSigned(w[1], w[2], true);
+  divExact(w[1], 2);
+  addSigned(w[2], w[0], true);
+  subtractFrom(w[3], w[2]);
+  divExact(w[3], 2);
+  addScaled(w[3], w[4], 2, tmp);
+  addSigned(w[2], w[1]);
+  addSigned(w[2], w[4], true);
+  addSigned(w[1], w[3], true);
+  composeLimbs(res, a_size + b_size, w.data(), w.size(), len);
+}
+
+// Toom-4 with evaluation points 0, 1, -1, 2, -2, 1/2, inf; the interpolation follows GMP's
+// mpn_toom_interpolate_7pts.
+void toom4Mul(uint32_t* res, const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size) {
+  size_t len = (a_size + 3) / 4;
+  signed_slots products(8, 2 * len + 6);
+  std::array<signed_limbs, 7> w;
+  for (signed_limbs& x : w) {
+    x = products.next();
+  }
+  signed_limbs tmp = products.next();
+  {
+    bool square = a == b && a_size == b_size;
+    signed_slots values(square ? 14 : 28, len + 3);
+    auto evaluate = [len, &values](const uint32_t* x, size_t x_size) {
+      std::array<signed_limbs, 7> u;
+      for (signed_limbs& y : u) {
+        y = values.next();
+      }
+      signed_limbs x1 = values.next();
+      signed_limbs x2 = values.next();
+      signed_limbs even = values.next();
+      signed_limbs odd = values.next();
+      signed_limbs even2 = values.next();
+      signed_limbs odd2 = values.next();
+      signed_limbs scaled = values.next();
+      setPiece(u[0], x, x_size, 0, len);
+      setPiece(x1, x, x_size, 1, len);
+      setPiece(x2, x, x_size, 2, len);
+      setPiece(u[6], x, x_size, 3, len);
+      setSum(even, u[0], x2);
+      setSum(odd, x1, u[6]);
+      setSum(u[2], even, odd);
+      setSum(u[3], even, odd, true);
+      assign(even2, u[0]);
+      addScaled(even2, x2, 4, scaled);
+      assign(odd2, x1);
+      scale(odd2, 2);
+      addScaled(odd2, u[6], 8, scaled);
+      setSum(u[1], even2, odd2, true);
+      setSum(u[4], even2, odd2);
+      assign(u[5], u[0]);
+      scale(u[5], 8);
+      addScaled(u[5], x1, 4, scaled);
+      addScaled(u[5], x2, 2, scaled);
+      addSigned(u[5], u[6]);
+      return u;
+    };
+    std::array<signed_limbs, 7> u = evaluate(a, a_size);
+    std::array<signed_limbs, 7> v = square ? u : evaluate(b, b_size);
+    for (size_t i = 0; i < w.size(); i++) {
+      mulSigned(w[i], u[i], square ? u[i] : v[i]);
+    }
+  }
+
+  addSigned(w[5], w[4]);
+  subtractFrom(w[1], w[4]);
+  divExact(w[1], 2);
+  addSigned(w[4], w[0], true);
+  addSigned(w[4], w[1], true);
+  divExact(w[4], 4);
+  addScaled(w[4], w[6], 16, tmp, true);
+  subtractFrom(w[3], w[2]);
+  divExact(w[3], 2);
+  addSigned(w[2], w[3], true);
+
+  addScaled(w[5], w[2], 65, tmp, true);
+  addSigned(w[2], w[6], true);
+  addSigned(w[2], w[0], true);
+  addScaled(w[5], w[2], 45, tmp);
+  divExact(w[5], 2);
+  addSigned(w[4], w[2], true);
+  divExact(w[4], 3);
+  addSigned(w[2], w[4], true);
+
+  subtractFrom(w[1], w[5]);
+  addScaled(w[5], w[3], 8, tmp, true);
+  divExact(w[5], 9);
+  addSigned(w[3], w[5], true);
+  divExact(w[1], 15);
+  addSigned(w[1], w[5]);
+  divExact(w[1], 2);
+  addSigned(w[5], w[1], true);
+  composeLimbs(res, a_size + b_size, w.data(), w.size(), len);
+}
+
+// Arithmetic modulo an NTT-friendly prime Mod < 2^31 in Montgomery form with R = 2^32.
+template <uint32_t Mod, uint32_t Generator>
+struct ntt_prime {
+  static constexpr uint32_t MOD = Mod;
+
+  static uint32_t reduce(uint64_t value) {
+    uint32_t m = static_cast<uint32_t>(value) * NEG_INVERSE;
+    uint32_t res = static_cast<uint32_t>((value + static_cast<uint64_t>(m) * Mod) >> 32);
+    return res >= Mod ? res - Mod : res;
+  }
+
+  static uint32_t mul(uint32_t a, uint32_t b) {
+    return reduce(static_cast<uint64_t>(a) * b);
+  }
+
+  static uint32_t add(uint32_t a, uint32_t b) {
+    uint32_t res = a + b;
+    return res >= Mod ? res - Mod : res;
+  }
+
+  static uint32_t sub(uint32_t a, uint32_t b) {
+    return a >= b ? a - b : a + Mod - b;
+  }
+
+  static uint32_t power(uint32_t base, uint64_t exp) {
+    uint64_t res = 1;
+    uint64_t cur = base;
+    for (; exp != 0; exp >>= 1) {
+      if (exp & 1) {
+        res = res * cur % Mod;
+      }
+      cur = cur * cur % Mod;
+    }
+    return static_cast<uint32_t>(res);
+  }
+
+  static uint32_t toMontgomery(uint32_t a) {
+    return mul(a, R_SQUARED);
+  }
+
+  // roots[m + j] = w^j for a primitive 2m-th root of unity w, stored in Montgomery form, for from <= m < n.
+  static void fillRoots(uint32_t* roots, size_t from, size_t n, bool inverse) {
+    for (size_t m = from; m < n; m *= 2) {
+      uint32_t w = power(Generator, (Mod - 1) / (2 * m));
+      if (inverse) {
+        w = power(w, Mod - 2);
+      }
+      uint32_t w_montgomery = toMontgomery(w);
+      roots[m] = toMontgomery(1);
+      for (size_t j = 1; j < m; j++) {
+        roots[m + j] = mul(roots[m + j - 1], w_montgomery);
+      }
+    }
+  }
+
+  // The entries for m do not depend on the transform length, so short tables are cached per thread and direction and
+  // grow to the largest length seen. Longer ones are written to spill, which then holds n limbs.
+  static const uint32_t* rootTable(size_t n, bool inverse, uint32_t* spill) {
+    if (n > NTT_ROOT_CACHE_SIZE) {
+      fillRoots(spill, 1, n, inverse);
+      return spill;
+    }
+    thread_local std::array<std::vector<uint32_t>, 2> tables;
+    std::vector<uint32_t>& roots = tables[inverse];
+    if (roots.size() < n) {
+      size_t from = std::max<size_t>(roots.size(), 1);
+      roots.resize(std::max<size_t>(n, 2));
+      fillRoots(roots.data(), from, n, inverse);
+    }
+    return roots.data();
+  }
+
+  // Decimation in frequency: natural order in, bit-reversed order out.
+  static void forward(uint32_t* a, size_t n, const uint32_t* roots) {
+    for (size_t m = n / 2; m >= 1; m /= 2) {
+      for (size_t i = 0; i < n; i += 2 * m) {
+        for (size_t j = 0; j < m; j++) {
+          uint32_t u = a[i + j];
+          uint32_t v = a[i + j + m];
+          a[i + j] = add(u, v);
+          a[i + j + m] = mul(sub(u, v), roots[m + j]);
+        }
+      }
+    }
+  }
+
+  // Decimation in time: bit-reversed order in, natural order out, without the 1/n factor.
+  static void inverse(uint32_t* a, size_t n, const uint32_t* roots) {
+    for (size_t m = 1; m < n; m *= 2) {
+      for (size_t i = 0; i < n; i += 2 * m) {
+        for (size_t j = 0; j < m; j++) {
+          uint32_t u = a[i + j];
+          uint32_t v = mul(a[i + j + m], roots[m + j]);
+          a[i + j] = add(u, v);
+          a[i + j + m] = sub(u, v);
+        }
+      }
+    }
+  }
+
+  static void load(uint32_t* res, const uint32_t* a, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      res[i] = a[i] % Mod;
+    }
+  }
+
+  // res[0, n) = cyclic convolution of length n (a power of two) of a and b reduced modulo Mod; res starts zeroed.
+  static void convolve(uint32_t* res, const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size, size_t n) {
+    scratch_buffer spill(n > NTT_ROOT_CACHE_SIZE ? n : 0);
+    const uint32_t* roots = rootTable(n, false, spill.data());
+    load(res, a, a_size);
+    forward(res, n, roots);
+    if (a == b && a_size == b_size) {
+      for (size_t i = 0; i < n; i++) {
+        res[i] = mul(res[i], res[i]);
+      }
+    } else {
+      scratch_buffer fb(n);
+      load(fb.data(), b, b_size);
+      forward(fb.data(), n, roots);
+      for (size_t i = 0; i < n; i++) {
+        res[i] = mul(res[i], fb[i]);
+      }
+    }
+    inverse(res, n, rootTable(n, true, spill.data()));
+    // The pointwise products carry an extra 1/R, so scale by R^2 / n to get back to plain values.
+    uint32_t scale = toMontgomery(toMontgomery(power(static_cast<uint32_t>(n % Mod), Mod - 2)));
+    for (size_t i = 0; i < n; i++) {
+      res[i] = mul(res[i], scale);
+    }
+  }
+
+private:
+  static constexpr uint32_t NEG_INVERSE = 0 - inverseLimb(Mod);
+  static constexpr uint32_t R_SQUARED = static_cast<uint32_t>(-static_cast<uint64_t>(Mod) % Mod);
+};
+
+using ntt_prime1 = ntt_prime<2013265921, 31>;
+using ntt_prime2 = ntt_prime<469762049, 3>;
+using ntt_prime3 = ntt_prime<1811939329, 13>;
+
+// Three-prime NTT: the convolution of 32-bit limbs is exact as long as min(a_size, b_size) * 2^64 stays
+// below ntt_prime1 * ntt_prime2 * ntt_prime3 ~ 2^90.4, which holds for every length up to NTT_MAX_SIZE.
+// The coefficients are then recovered with Garner's CRT and carried into the result.
+void nttMul(uint32_t* res, const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size) {
+  size_t res_size = a_size + b_size;
+  size_t n = std::bit_ceil(res_size - 1);
+  scratch_buffer r1(n);
+  scratch_buffer r2(n);
+  scratch_buffer r3(n);
+  ntt_prime1::convolve(r1.data(), a, a_size, b, b_size, n);
+  ntt_prime2::convolve(r2.data(), a, a_size, b, b_size, n);
+  ntt_prime3::convolve(r3.data(), a, a_size, b, b_size, n);
+
+  constexpr uint64_t p1 = ntt_prime1::MOD;
+  constexpr uint64_t p2 = ntt_prime2::MOD;
+  constexpr uint64_t p3 = ntt_prime3::MOD;
+  constexpr uint64_t p1_p2 = p1 * p2;
+  constexpr uint64_t p1_inverse_mod_p2 = 163395495;
+  constexpr uint64_t p1_p2_inverse_mod_p3 = 634178753;
+  uint64_t carry = 0;
+  for (size_t i = 0; i < res_size; i++) {
+    uint64_t low = carry;
+    uint64_t high = 0;
+    if (i + 1 < res_size) {
+      uint64_t x1 = r1[i];
+      uint64_t t1 = (r2[i] + p2 - x1 % p2) * p1_inverse_mod_p2 % p2;
+      uint64_t x12 = x1 + p1 * t1;
+      uint64_t t2 = (r3[i] + p3 - x12 % p3) * p1_p2_inverse_mod_p3 % p3;
+      low += x12 + (p1_p2 & 0xffffffff) * t2;
+      high = (p1_p2 >> 32) * t2;
+    }
+    res[i] = static_cast<uint32_t>(low);
+    carry = (low >> 32) + high;
+  }
+}
+
+// a = a1 * B^half + a0, a^2 = a1^2 * B^2half + (a0^2 + a1^2 - (a0 - a1)^2) * B^half + a0^2.
+void karatsubaSqr(uint32_t* res, const uint32_t* a, size_t size) {
+  size_t half = (size + 1) / 2;
+  size_t high_size = size - half;
+  sqrLimbs(res, a, half);
+  sqrLimbs(res + 2 * half, a + half, high_size);
+
+  scratch_buffer diff(a, a + half);
+  if (compareLimbs(a, significantSize(a, half), a + half, significantSize(a + half, high_size)) >= 0) {
+    subFrom(diff.data(), half, a + half, high_size);
+  } else {
+    std::fill(std::copy_n(a + half, high_size, diff.begin()), diff.end(), 0);
+    subFrom(diff.data(), half, a, half);
+  }
+  scratch_buffer diff_square(2 * half);
+  sqrLimbs(diff_square.data(), diff.data(), half);
+
+  scratch_buffer middle(res, res + 2 * half + 1);
+  middle.back() = addTo(middle.data(), 2 * half, res + 2 * half, 2 * high_size);
+  subFrom(middle.data(), middle.size(), diff_square.data(), diff_square.size());
+  addTo(res + half, 2 * size - half, middle.data(), significantSize(middle.data(), middle.size()));
+}
+
+void sqrLimbs(uint32_t* res, const uint32_t* a, size_t size) {
+  if (size < SQR_KARATSUBA_THRESHOLD) {
+    schoolbookSqr(res, a, size);
+  } else if (size >= NTT_THRESHOLD && 2 * size <= NTT_MAX_SIZE) {
+    nttMul(res, a, size, a, size);
+  } else if (size >= SQR_TOOM4_THRESHOLD) {
+    toom4Mul(res, a, size, a, size);
+  } else if (size >= SQR_TOOM3_THRESHOLD) {
+    toom3Mul(res, a, size, a, size);
+  } else {
+    karatsubaSqr(res, a, size);
+  }
+}
+
+void mulLimbs(uint32_t* res, const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size) {
+  if (a == b && a_size == b_size) {
+    sqrLimbs(res, a, a_size);
+    return;
+  }
+  if (a_size < b_size) {
+    std::swap(a, b);
+    std::swap(a_size, b_size);
+  }
+  if (b_size < KARATSUBA_THRESHOLD) {
+    schoolbookMul(res, a, a_size, b, b_size);
+  } else if (2 * b_size <= a_size + 1) {
+    std::fill_n(res, a_size + b_size, 0);
+    scratch_buffer chunk_res(2 * b_size);
+    for (size_t i = 0; i < a_size; i += b_size) {
+      size_t chunk_size = std::min(b_size, a_size - i);
+      mulLimbs(chunk_res.data(), a + i, chunk_size, b, b_size);
+      addTo(res + i, a_size + b_size - i, chunk_res.data(), chunk_size + b_size);
+    }
+  } else if (b_size >= NTT_THRESHOLD && a_size + b_size <= NTT_MAX_SIZE) {
+    nttMul(res, a, a_size, b, b_size);
+  } else if (b_size >= TOOM4_THRESHOLD && b_size > 3 * ((a_size + 3) / 4)) {
+    toom4Mul(res, a, a_size, b, b_size);
+  } else if (b_size >= TOOM3_THRESHOLD && b_size > 2 * ((a_size + 2) / 3)) {
+    toom3Mul(res, a, a_size, b, b_size);
+  } else {
+    karatsubaMul(res, a, a_size, b, b_size);
+  }
+}
+
+// acc[0, size) +-= a * b with size > a_size + b_size. Short b is accumulated row by row without a product buffer.
+// Returns the carry or borrow out of acc.
+uint32_t accumulateProduct(uint32_t* acc, size_t size, const uint32_t* a, size_t a_size, const uint32_t* b,
+                           size_t b_size, bool subtract) {
+  if (a_size < b_size) {
+    std::swap(a, b);
+    std::swap(a_size, b_size);
+  }
+  uint32_t carry = 0;
+  if (b_size >= KARATSUBA_THRESHOLD) {
+    scratch_buffer product(a_size + b_size);
+    mulLimbs(product.data(), a, a_size, b, b_size);
+    return subtract ? subFrom(acc, size, product.data(), product.size())
+                    : addTo(acc, size, product.data(), product.size());
+  }
+  size_t i = 0;
+#ifdef BIGINT_WIDE_KERNELS
+  for (; i + 1 < b_size; i += 2) {
+    uint32_t top[2];
+    uint64_t word = loadWord(b + i);
+    storeWord(top, subtract ? subMulWord(acc + i, a, a_size, word) : addMulWord(acc + i, a, a_size, word));
+    carry |= subtract ? subFrom(acc + i + a_size, size - i - a_size, top, 2)
+                      : addTo(acc + i + a_size, size - i - a_size, top, 2);
+  }
+#endif
+  for (; i < b_size; i++) {
+    uint32_t top = subtract ? subMulDigit(acc + i, a, a_size, b[i]) : addMulDigit(acc + i, a, a_size, b[i]);
+    carry |= subtract ? subFrom(acc + i + a_size, size - i - a_size, &top, 1)
+                      : addTo(acc + i + a_size, size - i - a_size, &top, 1);
+  }
+  return carry;
+}
+
+// Knuth's algorithm D. b is normalized (top bit set) and has at least two limbs. The low a_size - b_size
+// quotient limbs go to q, the top one is returned, and the remainder is left in a[0, b_size).
+uint32_t schoolbookDiv(uint32_t* q, uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size) {
+  size_t q_size = a_size - b_size;
+  uint32_t q_high = compareLimbs(a + q_size, b_size, b, b_size) >= 0;
+  if (q_high) {
+    subFrom(a + q_size, b_size, b, b_size);
+  }
+  uint32_t b1 = b[b_size - 1];
+  uint32_t b0 = b[b_size - 2];
+  for (size_t j = q_size; j-- > 0;) {
+    uint32_t top = a[j + b_size];
+    uint64_t numerator = (static_cast<uint64_t>(top) << 32) | a[j + b_size - 1];
+    uint64_t q_hat = top >= b1 ? UINT32_MAX : numerator / b1;
+    uint64_t r_hat = numerator - q_hat * b1;
+    while (r_hat <= UINT32_MAX && q_hat * b0 > ((r_hat << 32) | a[j + b_size - 2])) {
+      q_hat--;
+      r_hat += b1;
+    }
+    uint32_t borrow = subMulDigit(a + j, b, b_size, static_cast<uint32_t>(q_hat));
+    if (top < borrow) {
+      q_hat--;
+      addTo(a + j, b_size, b, b_size);
+    }
+    a[j + b_size] = 0;
+    q[j] = static_cast<uint32_t>(q_hat);
+  }
+  return q_high;
+}
+
+// Burnikel-Ziegler style 2n by n division: the top half of the quotient is computed from the top halves of
+// a and b, corrected by the product with the low half of b, then the same is done for the bottom half.
+// Remainder is left in a[0, n), the top quotient limb is returned.
+uint32_t recursiveDiv(uint32_t* q, uint32_t* a, const uint32_t* b, size_t n) {
+  if (n < DIVISION_THRESHOLD) {
+    return schoolbookDiv(q, a, 2 * n, b, n);
+  }
+  size_t low = n / 2;
+  size_t high = n - low;
+  scratch_buffer product(n);
+
+  uint32_t q_high = recursiveDiv(q + low, a + 2 * low, b + low, high);
+  mulLimbs(product.data(), q + low, high, b, low);
+  uint32_t borrow = subFrom(a + low, n, product.data(), n);
+  if (q_high != 0) {
+    borrow += subFrom(a + n, low, b, low);
+  }
+  while (borrow != 0) {
+    q_high -= decrementLimbs(q + low, high);
+    borrow -= addTo(a + low, n, b, n);
+  }
+
+  uint32_t q_low_high = recursiveDiv(q, a + high, b + high, low);
+  mulLimbs(product.data(), b, high, q, low);
+  borrow = subFrom(a, n, product.data(), n);
+  if (q_low_high != 0) {
+    borrow += subFrom(a + low, high, b, high);
+  }
+  while (borrow != 0) {
+    decrementLimbs(q, low);
+    borrow -= addTo(a, n, b, n);
+  }
+  return q_high;
+}
+
+// Same contract as schoolbookDiv. The quotient is produced in blocks of b_size limbs, each one a 2n by n
+// recursiveDiv step; a leftover top block shorter than b_size is divided by the top limbs of b first and
+// then corrected with the rest of b.
+uint32_t divLimbs(uint32_t* q, uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size) {
+  size_t q_size = a_size - b_size;
+  if (b_size < DIVISION_THRESHOLD || q_size < DIVISION_THRESHOLD) {
+    return schoolbookDiv(q, a, a_size, b, b_size);
+  }
+  size_t first = q_size % b_size == 0 ? b_size : q_size % b_size;
+  size_t pos = q_size - first;
+  uint32_t q_high;
+  if (first == b_size) {
+    q_high = recursiveDiv(q + pos, a + pos, b, b_size);
+  } else if (first < DIVISION_THRESHOLD) {
+    q_high = schoolbookDiv(q + pos, a + pos, first + b_size, b, b_size);
+  } else {
+    size_t rest = b_size - first;
+    q_high = recursiveDiv(q + pos, a + a_size - 2 * first, b + rest, first);
+    scratch_buffer product(b_size);
+    mulLimbs(product.data(), q + pos, first, b, rest);
+    uint32_t borrow = subFrom(a + pos, b_size, product.data(), b_size);
+    if (q_high != 0) {
+      borrow += subFrom(a + pos + first, rest, b, rest);
+    }
+    while (borrow != 0) {
+      q_high -= decrementLimbs(q + pos, first);
+      borrow -= addTo(a + pos, b_size, b, b_size);
+    }
+  }
+  while (pos > 0) {
+    pos -= b_size;
+    recursiveDiv(q + pos, a + pos, b, b_size);
+  }
+  return q_high;
+}
+
+thread_local std::pmr::memory_resource* limb_resource = nullptr;
+} // namespace
+
+std::pmr::memory_resource* big_integer_resource() noexcept {
+  return limb_resource;
+}
+
+std::pmr::memory_resource* set_big_integer_resource(std::pmr::memory_resource* resource) noexcept {
+  return std::exchange(limb_resource, resource);
+}
+
+std::pmr::memory_resource* limb_vector::resource() const noexcept {
+  return isSmall() ? limb_resource : _resource;
+}
+
+void limb_vector::reallocate(size_t capacity, std::pmr::memory_resource* resource) {
+  uint32_t* heap = resource != nullptr
+                       ? static_cast<uint32_t*>(resource->allocate(capacity * sizeof(uint32_t), alignof(uint32_t)))
+                       : new uint32_t[capacity];
+  std::copy_n(data(), _size, heap);
+  if (!isSmall()) {
+    release(_heap, _capacity, _resource);
+  }
+  _heap = heap;
+  _capacity = capacity;
+  _resource = resource;
+}
+
+void limb_vector::release(uint32_t* heap, size_t capacity, std::pmr::memory_resource* resource) noexcept {
+  if (resource != nullptr) {
+    resource->deallocate(heap, capacity * sizeof(uint32_t), alignof(uint32_t));
+  } else {
+    delete[] heap;
+  }
+}
+
+big_integer::big_integer() : _sign(false) {}
+
+big_integer::big_integer(const big_integer& other) = default;
+
+big_integer::big_integer(big_integer&& other) noexcept : _data(std::move(other._data)), _sign(other._sign) {
+  other._sign = false;
+}
+
+big_integer::big_integer(unsigned long long a) : _sign(false) {
+  do {
+    _data.push_back(a % base);
+    a /= base;
+  } while (a != 0);
+  trim();
+}
+
+big_integer::big_integer(long long a) {
+  uint64_t value;
+  if (a < 0) {
+    _sign = true;
+    if (a == LONG_LONG_MIN) {
+      value = static_cast<uint64_t>(std::abs(a + 1)) + 1;
+    } else {
+      value = -a;
+    }
+  } else {
+    _sign = false;
+    value = a;
+  }
+  do {
+    _data.push_back(value % base);
+    value /= base;
+  } while (value != 0);
+  trim();
+}
+
+namespace {
+// 10^(9 * 2^k), cached per thread; a deque keeps references valid while the table grows. The cache outlives any
+// resource installed by the caller, so its limbs always come from the default one.
+const big_integer& decimalPower(size_t k) {
+  thread_local std::deque<big_integer> powers;
+  if (powers.size() <= k) {
+    big_integer_resource_scope default_resource(nullptr);
+    if (powers.empty()) {
+      powers.emplace_back(DECIMAL_CHUNK_BASE);
+    }
+    while (powers.size() <= k) {
+      powers.push_back(sqr(powers.back()));
+    }
+  }
+  return powers[k];
+}
+} // namespace
+
+big_integer::big_integer(std::string_view str) {
+  if (str.empty()) {
+    throw std::invalid_argument("Invalid argument: non-empty string expected");
+  }
+  bool negative = str[0] == '-';
+  if (negative) {
+    str.remove_prefix(1);
+    if (str.empty()) {
+      throw std::invalid_argument("Invalid argument: no digits after unary operation");
+    }
+  }
+  if (!std::all_of(str.begin(), str.end(), [](char c) { return '0' <= c && c <= '9'; })) {
+    throw std::invalid_argument("Invalid argument: only digits expected");
+  }
+  _data = std::move(readDecimal(str)._data);
+  _sign = negative && !isZero();
+}
+
+big_integer big_integer::readDecimal(std::string_view digits) {
+  size_t chunks = (digits.size() + 8) / 9;
+  if (chunks <= FROM_STRING_THRESHOLD) {
+    big_integer result;
+    size_t next = digits.size() - 9 * (chunks - 1);
+    for (size_t i = 0; i < digits.size(); i += next, next = 9) {
+      uint64_t carry = 0;
+      uint32_t multiplier = 1;
+      for (size_t j = i; j < i + next; ++j) {
+        carry = carry * 10 + (digits[j] - '0');
+        multiplier *= 10;
+      }
+      for (uint32_t& limb : result._data) {
+        uint64_t cur = static_cast<uint64_t>(limb) * multiplier + carry;
+        limb = static_cast<uint32_t>(cur);
+        carry = cur >> 32;
+      }
+      if (carry != 0) {
+        result._data.push_back(static_cast<uint32_t>(carry));
+      }
+    }
+    return result;
+  }
+  size_t k = std::bit_width(chunks - 1) - 1;
+  size_t low_digits = size_t(9) << k;
+  big_integer result = readDecimal(digits.substr(0, digits.size() - low_digits));
+  result *= decimalPower(k);
+  result += readDecimal(digits.substr(digits.size() - low_digits));
+  return result;
+}
+
+big_integer::~big_integer() = default;
+
+big_integer& big_integer::operator=(const big_integer& other) {
+  if (&other != this) {
+    _data = other._data;
+    _sign = other._sign;
+  }
+  return *this;
+}
+
+big_integer& big_integer::operator=(big_integer&& other) noexcept {
+  if (&other != this) {
+    _data = std::move(other._data);
+    _sign = other._sign;
+    other._sign = false;
+  }
+  return *this;
+}
+
+// All terms are added column by column in one pass: the column sum of up to 2^31 signed limbs plus the carry fits in
+// int64_t. Terms are sorted by length so that the terms still contributing at a column form a prefix.
+void big_integer::assignSum(lazy_term* terms, size_t count) {
+  bool aliased = false;
+  for (size_t i = 0; i < count; i++) {
+    const big_integer& value = *terms[i].value;
+    terms[i].limbs = value._data.data();
+    terms[i].size = value._data.size();
+    terms[i].mask = -static_cast<int64_t>(terms[i].negative != value._sign);
+    aliased |= &value == this;
+  }
+  std::sort(terms, terms + count, [](const lazy_term& a, const lazy_term& b) { return a.size > b.size; });
+  size_t size = terms[0].size;
+  limb_vector res = aliased ? limb_vector(size + 1, _data.resource()) : std::move(_data);
+  res.resize(size + 1);
+  uint32_t* out = res.data();
+  int64_t carry = 0;
+  size_t active = count;
+  for (size_t i = 0; i < size;) {
+    while (terms[active - 1].size <= i) {
+      active--;
+    }
+    if (i + 1 < terms[active - 1].size) {
+      int64_t low = carry;
+      int64_t high = 0;
+      for (size_t j = 0; j < active; j++) {
+        low += (static_cast<int64_t>(terms[j].limbs[i]) ^ terms[j].mask) - terms[j].mask;
+        high += (static_cast<int64_t>(terms[j].limbs[i + 1]) ^ terms[j].mask) - terms[j].mask;
+      }
+      high += low >> 32;
+      out[i] = static_cast<uint32_t>(low);
+      out[i + 1] = static_cast<uint32_t>(high);
+      carry = high >> 32;
+      i += 2;
+    } else {
+      int64_t sum = carry;
+      for (size_t j = 0; j < active; j++) {
+        sum += (static_cast<int64_t>(terms[j].limbs[i]) ^ terms[j].mask) - terms[j].mask;
+      }
+      out[i] = static_cast<uint32_t>(sum);
+      carry = sum >> 32;
+      i++;
+    }
+  }
+  _sign = carry < 0;
+  if (_sign) {
+    carry = -carry - negateLimbs(out, size);
+  }
+  out[size] = static_cast<uint32_t>(carry);
+  _data = std::move(res);
+  trim();
+  zeroResult();
+}
+
+big_integer& big_integer::operator+=(const big_integer& rhs) {
+  if (_sign == rhs._sign) {
+    sumAbs(rhs);
+    return *this;
+  } else {
+    if (compareLessAbs(rhs)) {
+      _sign = rhs._sign;
+      rhs.subAbs(*this, *this);
+    } else {
+      subAbs(*this, rhs);
+    }
+    zeroResult();
+    return *this;
+  }
+}
+
+big_integer& big_integer::operator-=(const big_integer& rhs) {
+  _sign = !_sign;
+  *this += rhs;
+  _sign = !_sign;
+  zeroResult();
+  return *this;
+}
+
+big_integer& big_integer::operator*=(const big_integer& rhs) {
+  if (rhs.isZero() || isZero()) {
+    _data.clear();
+    _sign = false;
+    return *this;
+  }
+  if (&rhs == this) {
+    sqrAbs();
+    _sign = false;
+    return *this;
+  }
+  mulAbs(rhs);
+  _sign = _sign ^ rhs._sign;
+  zeroResult();
+  return *this;
+}
+
+big_integer& big_integer::operator/=(const big_integer& rhs) {
+  bigDivision(rhs);
+  zeroResult();
+  return *this;
+}
+
+big_integer& big_integer::operator%=(const big_integer& rhs) {
+  // The remainder is copied back so that this value keeps its own buffer, and with it its resource.
+  big_integer quotient = *this;
+  big_integer rem = quotient.bigDivision(rhs);
+  _data.assign(rem._data.begin(), rem._data.end());
+  _sign = rem._sign;
+  zeroResult();
+  return *this;
+}
+
+big_integer& big_integer::operator&=(const big_integer& rhs) {
+  applyBitWiseOp(rhs, std::bit_and());
+  zeroResult();
+  return *this;
+}
+
+big_integer& big_integer::operator|=(const big_integer& rhs) {
+  applyBitWiseOp(rhs, std::bit_or());
+  zeroResult();
+  return *this;
+}
+
+big_integer& big_integer::operator^=(const big_integer& rhs) {
+  applyBitWiseOp(rhs, std::bit_xor());
+  zeroResult();
+  return *this;
+}
+
+template <class BitWiseOperation>
+void big_integer::applyBitWiseOp(const big_integer& rhs, BitWiseOperation op) {
+  bool res_negative = op(_sign, rhs._sign);
+  size_t a_size = _data.size();
+  size_t b_size = rhs._data.size();
+  size_t size = std::max(a_size, b_size) + res_negative;
+  if constexpr (std::is_same_v<BitWiseOperation, std::bit_and<>>) {
+    size = std::min(size, _sign ? size : a_size);
+    size = std::min(size, rhs._sign ? size : b_size);
+  }
+  _data.resize(size);
+  uint32_t* res = _data.data();
+  const uint32_t* b = &rhs == this ? res : rhs._data.data();
+  if (_sign) {
+    if (rhs._sign) {
+      bitwiseLimbs<true, true>(res, size, res, a_size, b, b_size, op);
+    } else {
+      bitwiseLimbs<true, false>(res, size, res, a_size, b, b_size, op);
+    }
+  } else {
+    if (rhs._sign) {
+      bitwiseLimbs<false, true>(res, size, res, a_size, b, b_size, op);
+    } else {
+      bitwiseLimbs<false, false>(res, size, res, a_size, b, b_size, op);
+    }
+  }
+  _sign = res_negative;
+  trim();
+}
+
+big_integer& big_integer::operator<<=(int rhs) {
+  shiftLeft(rhs);
+  return *this;
+}
+
+big_integer& big_integer::operator>>=(int rhs) {
+  shiftRight(rhs);
+  return *this;
+}
+
+big_integer big_integer::operator+() const {
+  return *this;
+}
+
+big_integer big_integer::operator-() const& {
+  return -big_integer(*this);
+}
+
+big_integer big_integer::operator-() && {
+  if (!isZero()) {
+    _sign = !_sign;
+  }
+  return std::move(*this);
+}
+
+big_integer big_integer::operator~() const& {
+  return ~big_integer(*this);
+}
+
+big_integer big_integer::operator~() && {
+  if (_sign) {
+    decrementLimbs(_data.data(), _data.size());
+  } else if (incrementLimbs(_data.data(), _data.size()) != 0) {
+    _data.push_back(1);
+  }
+  _sign = !_sign;
+  trim();
+  zeroResult();
+  return std::move(*this);
+}
+
+big_integer& big_integer::operator++() {
+  if (_sign) {
+    subDigitAbs(1);
+  } else {
+    sumDigitAbs(1);
+  }
+  zeroResult();
+  return *this;
+}
+
+big_integer big_integer::operator++(int) {
+  big_integer tmp(*this);
+  ++(*this);
+  return tmp;
+}
+
+big_integer& big_integer::operator--() {
+  if (_sign) {
+    sumDigitAbs(1);
+  } else {
+    if (isZero()) {
+      _sign = true;
+      _data.push_back(1);
+    } else {
+      subDigitAbs(1);
+    }
+  }
+  zeroResult();
+  return *this;
+}
+
+big_integer big_integer::operator--(int) {
+  big_integer tmp(*this);
+  --(*this);
+  return tmp;
+}
+
+big_integer operator+(const big_integer& a, const big_integer& b) {
+  return big_integer(a) + b;
+}
+
+big_integer operator+(big_integer&& a, const big_integer& b) {
+  a += b;
+  return std::move(a);
+}
+
+big_integer operator+(const big_integer& a, big_integer&& b) {
+  b += a;
+  return std::move(b);
+}
+
+big_integer operator+(big_integer&& a, big_integer&& b) {
+  a += b;
+  return std::move(a);
+}
+
+big_integer operator-(const big_integer& a, const big_integer& b) {
+  return big_integer(a) - b;
+}
+
+big_integer operator-(big_integer&& a, const big_integer& b) {
+  a -= b;
+  return std::move(a);
+}
+
+big_integer operator*(const big_integer& a, const big_integer& b) {
+  if (&a == &b) {
+    return sqr(a);
+  }
+  return big_integer(a) * b;
+}
+
+big_integer operator*(big_integer&& a, const big_integer& b) {
+  a *= b;
+  return std::move(a);
+}
+
+big_integer operator*(const big_integer& a, big_integer&& b) {
+  b *= a;
+  return std::move(b);
+}
+
+big_integer operator*(big_integer&& a, big_integer&& b) {
+  a *= b;
+  return std::move(a);
+}
+
+big_integer sqr(const big_integer& a) {
+  big_integer res;
+  res._data.resize(2 * a._data.size());
+  sqrLimbs(res._data.data(), a._data.data(), a._data.size());
+  res.trim();
+  return res;
+}
+
+std::pair<big_integer, big_integer> divmod(const big_integer& a, const big_integer& b, division_rounding rounding) {
+  std::pair<big_integer, big_integer> res;
+  divmod(a, b, res.first, res.second, rounding);
+  return res;
+}
+
+void divmod(const big_integer& a, const big_integer& b, big_integer& quotient, big_integer& remainder,
+            division_rounding rounding) {
+  if (&b == &quotient || &b == &remainder) {
+    big_integer divisor = b;
+    divmod(a, divisor, quotient, remainder, rounding);
+    return;
+  }
+  quotient = a;
+  remainder = quotient.bigDivision(b);
+  quotient.zeroResult();
+  remainder.zeroResult();
+  if (rounding == division_rounding::floor && !remainder.isZero() && remainder._sign != b._sign) {
+    --quotient;
+    remainder += b;
+  }
+}
+
+void addmul(big_integer& acc, const big_integer& a, const big_integer& b) {
+  if (&acc == &a || &acc == &b) {
+    acc += a * b;
+    return;
+  }
+  acc.addProduct(a._data.data(), a._data.size(), b._data.data(), b._data.size(), a._sign != b._sign);
+}
+
+void addmul(big_integer& acc, const big_integer& a, uint32_t b) {
+  if (&acc == &a) {
+    acc += a * b;
+    return;
+  }
+  acc.addProduct(a._data.data(), a._data.size(), &b, b != 0, a._sign);
+}
+
+void submul(big_integer& acc, const big_integer& a, const big_integer& b) {
+  if (&acc == &a || &acc == &b) {
+    acc -= a * b;
+    return;
+  }
+  acc.addProduct(a._data.data(), a._data.size(), b._data.data(), b._data.size(), a._sign == b._sign);
+}
+
+void submul(big_integer& acc, const big_integer& a, uint32_t b) {
+  if (&acc == &a) {
+    acc -= a * b;
+    return;
+  }
+  acc.addProduct(a._data.data(), a._data.size(), &b, b != 0, !a._sign);
+}
+
+big_integer operator/(const big_integer& a, const big_integer& b) {
+  return big_integer(a) / b;
+}
+
+big_integer operator/(big_integer&& a, const big_integer& b) {
+  a /= b;
+  return std::move(a);
+}
+
+big_integer operator%(const big_integer& a, const big_integer& b) {
+  return big_integer(a) % b;
+}
+
+big_integer operator%(big_integer&& a, const big_integer& b) {
+  a %= b;
+  return std::move(a);
+}
+
+big_integer operator&(const big_integer& a, const big_integer& b) {
+  return big_integer(a) & b;
+}
+
+big_integer operator&(big_integer&& a, const big_integer& b) {
+  a &= b;
+  return std::move(a);
+}
+
+big_integer operator&(const big_integer& a, big_integer&& b) {
+  b &= a;
+  return std::move(b);
+}
+
+big_integer operator&(big_integer&& a, big_integer&& b) {
+  a &= b;
+  return std::move(a);
+}
+
+big_integer operator|(const big_integer& a, const big_integer& b) {
+  return big_integer(a) | b;
+}
+
+big_integer operator|(big_integer&& a, const big_integer& b) {
+  a |= b;
+  return std::move(a);
+}
+
+big_integer operator|(const big_integer& a, big_integer&& b) {
+  b |= a;
+  return std::move(b);
+}
+
+big_integer operator|(big_integer&& a, big_integer&& b) {
+  a |= b;
+  return std::move(a);
+}
+
+big_integer operator^(const big_integer& a, const big_integer& b) {
+  return big_integer(a) ^ b;
+}
+
+big_integer operator^(big_integer&& a, const big_integer& b) {
+  a ^= b;
+  return std::move(a);
+}
+
+big_integer operator^(const big_integer& a, big_integer&& b) {
+  b ^= a;
+  return std::move(b);
+}
+
+big_integer operator^(big_integer&& a, big_integer&& b) {
+  a ^= b;
+  return std::move(a);
+}
+
+big_integer operator<<(const big_integer& a, int b) {
+  return big_integer(a) << b;
+}
+
+big_integer operator<<(big_integer&& a, int b) {
+  a <<= b;
+  return std::move(a);
+}
+
+big_integer operator>>(const big_integer& a, int b) {
+  return big_integer(a) >> b;
+}
+
+big_integer operator>>(big_integer&& a, int b) {
+  a >>= b;
+  return std::move(a);
+}
+
+void shift_left(big_integer& a, size_t bits) {
+  a.shiftLeft(bits);
+}
+
+void shift_right(big_integer& a, size_t bits) {
+  a.shiftRight(bits);
+}
+
+bool operator==(const big_integer& a, const big_integer& b) {
+  return a._sign == b._sign && a._data == b._data;
+}
+
+bool operator!=(const big_integer& a, const big_integer& b) = default;
+
+bool operator<(const big_integer& a, const big_integer& b) {
+  if (a._sign != b._sign) {
+    return a._sign;
+  } else {
+    if (!a._sign) {
+      return a.compareLessAbs(b);
+    } else {
+      return b.compareLessAbs(a);
+    }
+  }
+}
+
+bool operator>(const big_integer& a, const big_integer& b) {
+  return b < a;
+}
 
-big_integer::big_integer() : _sign(false) {}
+bool operator<=(const big_integer& a, const big_integer& b) {
+  return !(a > b);
+}
 
-big_integer::big_integer(const big_integer& other) = default;
+bool operator>=(const big_integer& a, const big_integer& b) {
+  return !(a < b);
+}
 
-big_integer::big_integer(unsigned long long a) : _sign(false) {
-  do {
-    _data.push_back(a % base);
-    a /= base;
-  } while (a != 0);
-  trim();
+std::string to_string(const big_integer& a) {
+  if (a.isZero()) {
+    return "0";
+  }
+  size_t bits = 32 * a._data.size() - std::countl_zero(a._data.back());
+  size_t chunks = bits * 30103 / 100000 / 9 + 1;
+  std::string result(9 * chunks + 1, '0');
+  big_integer(a).writeDecimal(result.data() + 1, chunks);
+  size_t first = result.find_first_not_of('0', 1);
+  if (a._sign) {
+    result[--first] = '-';
+  }
+  result.erase(0, first);
+  return result;
 }
 
-big_integer::big_integer(long long a) {
-  uint64_t value;
-  if (a < 0) {
-    _sign = true;
-    if (a == LONG_LONG_MIN) {
-      value = static_cast<uint64_t>(std::abs(a + 1)) + 1;
-    } else {
-      value = -a;
+void big_integer::writeDecimal(char* out, size_t chunks) {
+  if (_data.size() <= TO_STRING_THRESHOLD) {
+    for (size_t i = chunks; i-- > 0 && !isZero();) {
+      uint32_t rem = singleWordDiv(DECIMAL_CHUNK_BASE);
+      for (size_t j = 9; j-- > 0; rem /= 10) {
+        out[9 * i + j] = static_cast<char>('0' + rem % 10);
+      }
     }
-  } else {
+    return;
+  }
+  size_t k = std::bit_width(chunks - 1) - 1;
+  size_t low_chunks = size_t(1) << k;
+  big_integer low = bigDivision(decimalPower(k));
+  writeDecimal(out, chunks - low_chunks);
+  low.writeDecimal(out + 9 * (chunks - low_chunks), low_chunks);
+}
+
+big_integer big_integer::bigDivision(const big_integer& rhs) {
+  if (rhs.isZero()) {
+    throw std::runtime_error("Runtime error: division by zero");
+  }
+
+  if (this->compareLessAbs(rhs)) {
+    big_integer tmp;
+    swap(tmp);
+    return tmp;
+  }
+  bool save_sign = _sign;
+  _sign = save_sign ^ rhs._sign;
+  big_integer rem;
+  // The reciprocal costs about as much as a balanced division by itself, so it only pays off for a large divisor
+  // when it is reused for several blocks of a long quotient.
+  size_t n = rhs._data.size();
+  if (n >= NEWTON_DIVISION_THRESHOLD && _data.size() - n >= 2 * n) {
+    big_reciprocal reciprocal(rhs);
     _sign = false;
-    value = a;
+    rem = reciprocal.divideAbs(*this);
+    _sign = save_sign ^ reciprocal._divisor._sign;
+    rem._sign = save_sign;
+    return rem;
   }
-  do {
-    _data.push_back(value % base);
-    value /= base;
-  } while (value != 0);
+  if (rhs._data.size() == 1) {
+    rem = singleWordDiv(rhs._data[0]);
+    rem._sign = save_sign;
+    return rem;
+  }
+
+  int shift = std::countl_zero(rhs._data.back());
+  scratch_buffer b(rhs._data.size());
+  shiftLeftLimbs(b.data(), rhs._data.data(), b.size(), shift);
+  _data.push_back(0);
+  shiftLeftLimbs(_data.data(), _data.data(), _data.size(), shift);
+  limb_vector q(_data.size() - b.size() + 1, _data.resource());
+  q.back() = divLimbs(q.data(), _data.data(), _data.size(), b.data(), b.size());
+
+  rem._data.resize(b.size());
+  shiftRightLimbs(rem._data.data(), _data.data(), b.size(), shift);
+  rem.trim();
+  rem._sign = save_sign;
+  _data.swap(q);
   trim();
+  return rem;
 }
 
-big_integer::big_integer(const std::string& str) {
-  if (str.empty()) {
-    throw std::invalid_argument("Invalid argument: non-empty string expected");
+void big_integer::sqrAbs() {
+  limb_vector res(2 * _data.size(), _data.resource());
+  sqrLimbs(res.data(), _data.data(), _data.size());
+  _data.swap(res);
+  trim();
+}
+
+void big_integer::mulAbs(const big_integer& b) {
+  limb_vector res(_data.size() + b._data.size(), _data.resource());
+  mulLimbs(res.data(), _data.data(), _data.size(), b._data.data(), b._data.size());
+  _data.swap(res);
+  trim();
+}
+
+void big_integer::addProduct(const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size, bool negative) {
+  if (a_size == 0 || b_size == 0) {
+    return;
   }
-  _sign = false;
-  if (str[0] == '-') {
-    _sign = true;
-    if (str.size() == 1) {
-      throw std::invalid_argument("Invalid argument: no digits after unary operation");
-    }
+  if (isZero()) {
+    _sign = negative;
   }
+  bool subtract = negative != _sign;
+  size_t size = std::max(_data.size(), a_size + b_size) + 1;
+  _data.resize(size);
+  if (accumulateProduct(_data.data(), size, a, a_size, b, b_size, subtract) != 0) {
+    negateLimbs(_data.data(), size);
+    _sign = !_sign;
+  }
+  trim();
+  zeroResult();
+}
 
-  for (size_t i = _sign; i < str.size(); i += 9) {
-    size_t next = std::min(static_cast<size_t>(9), str.size() - i);
-    uint32_t value = 0;
-    if (std::from_chars(str.c_str() + i, str.c_str() + i + next, value).ptr != str.c_str() + i + next) {
-      throw std::invalid_argument("Invalid argument: only digits expected");
-    }
+void big_integer::subDigitAbs(uint32_t b) {
+  uint32_t carry_flag = b;
 
-    if (next < 9) {
-      mulDigitAbs(static_cast<uint32_t>(std::pow(10, next)));
+  for (int i = 0; i < _data.size(); ++i) {
+    int64_t value = static_cast<int64_t>(_data[i]) - carry_flag;
+    if (value < 0) {
+      value += base;
+      carry_flag = true;
     } else {
-      mulDigitAbs(1000000000);
+      carry_flag = false;
     }
-    sumDigitAbs(value);
+    _data[i] = value;
   }
   trim();
 }
 
-big_integer::~big_integer() = default;
-
-big_integer& big_integer::operator=(const big_integer& other) {
-  if (&other != this) {
-    big_integer(other).swap(*this);
-  }
-  return *this;
+void big_integer::subAbs(big_integer& res, const big_integer& b) const {
+  size_t b_size = b._data.size();
+  res.stretch(_data.size());
+  subLimbs(res._data.data(), _data.data(), _data.size(), b._data.data(), b_size);
+  res.trim();
 }
 
-big_integer& big_integer::operator+=(const big_integer& rhs) {
-  if (_sign == rhs._sign) {
-    sumAbs(rhs);
-    return *this;
-  } else {
-    if (compareLessAbs(rhs)) {
-      _sign = rhs._sign;
-      rhs.subAbs(*this, *this);
-    } else {
-      subAbs(*this, rhs);
+void big_integer::sumDigitAbs(uint32_t b) {
+  uint32_t flag_over = b;
+  for (int i = 0; i < _data.size(); ++i) {
+    uint64_t value = static_cast<uint64_t>(_data[i]) + flag_over;
+    flag_over = value >= base;
+    if (flag_over) {
+      value -= base;
     }
-    zeroResult();
-    return *this;
+    _data[i] = value;
+  }
+  if (flag_over) {
+    _data.push_back(flag_over);
   }
 }
 
-big_integer& big_integer::operator-=(const big_integer& rhs) {
-  _sign = !_sign;
-  *this += rhs;
-  _sign = !_sign;
-  zeroResult();
-  return *this;
+void big_integer::sumAbs(const big_integer& b) {
+  stretch(b._data.size());
+  if (addTo(_data.data(), _data.size(), b._data.data(), b._data.size()) != 0) {
+    _data.push_back(1);
+  }
 }
 
-big_integer& big_integer::operator*=(const big_integer& rhs) {
-  if (rhs.isZero() || isZero()) {
-    _data.clear();
+uint32_t big_integer::singleWordDiv(uint32_t b) {
+  if (b == 0) {
+    throw std::runtime_error("Runtime error: division by zero");
+  }
+  uint32_t carry = 0;
+  for (std::ptrdiff_t i = _data.size() - 1; i >= 0; i--) {
+    uint64_t cur = _data[i] + carry * base;
+    _data[i] = static_cast<uint32_t>(cur / b);
+    carry = static_cast<uint32_t>(cur % b);
+  }
+  trim();
+  if (isZero()) {
     _sign = false;
-    return *this;
   }
-  mulAbs(rhs);
-  _sign = _sign ^ rhs._sign;
-  zeroResult();
-  return *this;
+  return carry;
 }
 
-big_integer& big_integer::operator/=(const big_integer& rhs) {
-  bigDivision(rhs);
-  zeroResult();
-  return *this;
+// Whole limbs and the bit offset move in the same pass, straight into a fresh buffer when the result outgrows the
+// current capacity.
+void big_integer::shiftLeft(size_t bits) {
+  if (isZero()) {
+    return;
+  }
+  size_t words = bits / 32;
+  int shift = static_cast<int>(bits % 32);
+  size_t size = _data.size();
+  size_t res_size = size + words + (shift != 0);
+  if (res_size > _data.capacity()) {
+    limb_vector res(res_size, _data.resource());
+    uint32_t out = shiftLeftLimbs(res.data() + words, _data.data(), size, shift);
+    if (shift != 0) {
+      res[size + words] = out;
+    }
+    _data.swap(res);
+  } else {
+    _data.resize(res_size);
+    uint32_t out = shiftLeftLimbs(_data.data() + words, _data.data(), size, shift);
+    std::fill(_data.begin(), _data.begin() + words, 0);
+    if (shift != 0) {
+      _data[size + words] = out;
+    }
+  }
+  trim();
 }
 
-big_integer& big_integer::operator%=(const big_integer& rhs) {
-  bigDivision(rhs).swap(*this);
-  zeroResult();
-  return *this;
+// Rounds toward negative infinity: a negative value with nonzero bits shifted out moves one further from zero.
+void big_integer::shiftRight(size_t bits) {
+  size_t words = bits / 32;
+  int shift = static_cast<int>(bits % 32);
+  size_t size = _data.size();
+  if (words >= size) {
+    _data.clear();
+    if (_sign) {
+      _data.push_back(1);
+    }
+    return;
+  }
+  bool inexact = std::any_of(_data.begin(), _data.begin() + words, [](uint32_t limb) { return limb != 0; });
+  inexact |= shiftRightLimbs(_data.data(), _data.data() + words, size - words, shift) != 0;
+  _data.resize(size - words);
+  trim();
+  if (_sign && inexact && incrementLimbs(_data.data(), _data.size()) != 0) {
+    _data.push_back(1);
+  }
 }
 
-big_integer& big_integer::operator&=(const big_integer& rhs) {
-  applyBitWiseOp(rhs, std::bit_and());
-  zeroResult();
-  return *this;
+void big_integer::trim() {
+  while (!_data.empty() && _data.back() == 0) {
+    _data.pop_back();
+  }
 }
 
-big_integer& big_integer::operator|=(const big_integer& rhs) {
-  applyBitWiseOp(rhs, std::bit_or());
-  zeroResult();
-  return *this;
+bool big_integer::isZero() const {
+  return _data.empty();
 }
 
-big_integer& big_integer::operator^=(const big_integer& rhs) {
-  applyBitWiseOp(rhs, std::bit_xor());
-  zeroResult();
-  return *this;
+void big_integer::zeroResult() {
+  if (isZero()) {
+    _sign = false;
+  }
 }
 
-big_integer& big_integer::operator<<=(int rhs) {
-  _data.insert(_data.begin(), rhs / 32, 0);
-  mulDigitAbs(static_cast<uint32_t>(1) << (rhs % 32));
-  return *this;
+void big_integer::swap(big_integer& other) {
+  _data.swap(other._data);
+  std::swap(_sign, other._sign);
 }
 
-big_integer& big_integer::operator>>=(int rhs) {
-  if (rhs / 32 >= _data.size()) {
-    _data.clear();
-    _sign = false;
-    return *this;
+void big_integer::stretch(size_t size) {
+  if (size > _data.size()) {
+    _data.resize(size, 0);
   }
-  _data.erase(_data.begin(), _data.begin() + rhs / 32);
-  singleWordDiv(static_cast<uint32_t>(1) << (rhs % 32));
-  if (_sign) {
-    --(*this);
+}
+
+bool big_integer::compareLessAbs(const big_integer& other) const {
+  if (isZero() && other.isZero()) {
+    return false;
   }
-  return *this;
+
+  if (_data.size() != other._data.size()) {
+    return _data.size() < other._data.size();
+  }
+
+  return std::lexicographical_compare(_data.rbegin(), _data.rend(), other._data.rbegin(), other._data.rend());
 }
 
-big_integer big_integer::operator+() const {
-  return *this;
+namespace {
+// floor(2^(2k) / d) for 2^(k-1) <= d < 2^k, up to a few units. The top h bits of d give a reciprocal v_high with
+// about half the precision, and one Newton step v = v_high * 2^(k-h) + v_high * e / 2^(2h), where
+// e = 2^(k+h) - d * v_high, doubles it. Only the top bits of e contribute to the correction.
+big_integer reciprocal(const big_integer& d, size_t k) {
+  big_integer power = 1;
+  if (k <= RECIPROCAL_THRESHOLD_BITS) {
+    shift_left(power, 2 * k);
+    return power / d;
+  }
+  size_t h = k / 2 + 16;
+  size_t t = k > h + 32 ? k - h - 32 : 0;
+  big_integer d_high = d;
+  shift_right(d_high, k - h);
+  big_integer v_high = reciprocal(d_high, h);
+  shift_left(power, k + h);
+  big_integer e = power - d * v_high;
+  shift_right(e, t);
+  big_integer correction = v_high * e;
+  shift_right(correction, 2 * h - t);
+  shift_left(v_high, k - h);
+  return v_high + correction;
 }
+} // namespace
 
-big_integer big_integer::operator-() const {
-  if (!isZero()) {
-    big_integer tmp(*this);
-    tmp._sign = !tmp._sign;
-    return tmp;
+big_reciprocal::big_reciprocal(const big_integer& divisor) : _divisor(divisor) {
+  if (divisor.isZero()) {
+    throw std::runtime_error("Runtime error: division by zero");
   }
-  return *this;
+  _shift = std::countl_zero(divisor._data.back());
+  _normalized = divisor << _shift;
+  _normalized._sign = false;
+  _inverse = reciprocal(_normalized, 32 * _normalized._data.size());
 }
 
-big_integer big_integer::operator~() const {
-  big_integer tmp(*this);
-  ++tmp;
-  tmp._sign = !tmp._sign;
-  return tmp;
+const big_integer& big_reciprocal::divisor() const {
+  return _divisor;
 }
 
-big_integer& big_integer::operator++() {
-  if (_sign) {
-    subDigitAbs(1);
-  } else {
-    sumDigitAbs(1);
+// Barrett reduction, one block of n = |divisor| limbs at a time from the top: the block estimate is within a
+// few units of the true quotient digit.
+big_integer big_reciprocal::divideAbs(big_integer& a) const {
+  size_t n = _normalized._data.size();
+  size_t k = 32 * n;
+  a <<= _shift;
+  size_t blocks = (a._data.size() + n - 1) / n;
+  limb_vector q(blocks * n, a._data.resource());
+  big_integer rem;
+  for (size_t i = blocks; i-- > 0;) {
+    big_integer cur;
+    cur._data.assign(a._data.begin() + i * n, a._data.begin() + std::min((i + 1) * n, a._data.size()));
+    cur._data.resize(n);
+    cur._data.insert(cur._data.end(), rem._data.begin(), rem._data.end());
+    cur.trim();
+    big_integer cur_high = cur;
+    shift_right(cur_high, k - 1);
+    big_integer q_block = cur_high * _inverse;
+    shift_right(q_block, k + 1);
+    rem = cur - q_block * _normalized;
+    while (rem < 0) {
+      rem += _normalized;
+      --q_block;
+    }
+    while (rem >= _normalized) {
+      rem -= _normalized;
+      ++q_block;
+    }
+    std::copy(q_block._data.begin(), q_block._data.end(), q.begin() + i * n);
   }
-  zeroResult();
-  return *this;
+  a._data.swap(q);
+  a.trim();
+  rem >>= _shift;
+  return rem;
 }
 
-big_integer big_integer::operator++(int) {
-  big_integer tmp(*this);
-  ++(*this);
-  return tmp;
+big_integer big_reciprocal::divide(const big_integer& a) const {
+  big_integer q(a);
+  q._sign = false;
+  divideAbs(q);
+  q._sign = a._sign ^ _divisor._sign;
+  q.zeroResult();
+  return q;
 }
 
-big_integer& big_integer::operator--() {
-  if (_sign) {
-    sumDigitAbs(1);
-  } else {
-    if (isZero()) {
-      _sign = true;
-      _data.push_back(1);
-    } else {
-      subDigitAbs(1);
+big_integer big_reciprocal::remainder(const big_integer& a) const {
+  big_integer q(a);
+  q._sign = false;
+  big_integer rem = divideAbs(q);
+  rem._sign = a._sign;
+  rem.zeroResult();
+  return rem;
+}
+
+namespace {
+// res[0, size) = a * b mod B^size for size-limb a and b; short operands only compute the rows below the cut.
+void mulLowLimbs(uint32_t* res, const uint32_t* a, const uint32_t* b, size_t size) {
+  if (size >= KARATSUBA_THRESHOLD) {
+    scratch_buffer product(2 * size);
+    mulLimbs(product.data(), a, size, b, size);
+    std::copy_n(product.data(), size, res);
+    return;
+  }
+  std::fill_n(res, size, 0);
+  for (size_t i = 0; i < size; i++) {
+    addMulDigit(res + i, b, size - i, a[i]);
+  }
+}
+
+// Montgomery reduction: res[0, n) = t * 2^(-32n) mod m for t[0, 2n) < m * 2^(32n), where m_inv = -m^(-1) mod 2^64.
+// Each step clears the low limbs of t by adding a multiple of m. t is clobbered.
+void montgomeryReduce(uint32_t* res, uint32_t* t, const uint32_t* m, size_t n, uint64_t m_inv) {
+  uint32_t carry = 0;
+  size_t i = 0;
+#ifdef BIGINT_WIDE_KERNELS
+  for (; i + 1 < n; i += 2) {
+    uint64_t u = loadWord(t + i) * m_inv;
+    uint128_t top = static_cast<uint128_t>(loadWord(t + i + n)) + addMulWord(t + i, m, n, u) + carry;
+    storeWord(t + i + n, static_cast<uint64_t>(top));
+    carry = static_cast<uint32_t>(top >> 64);
+  }
+#endif
+  for (; i < n; i++) {
+    uint32_t u = t[i] * static_cast<uint32_t>(m_inv);
+    uint64_t top = static_cast<uint64_t>(t[i + n]) + addMulDigit(t + i, m, n, u) + carry;
+    t[i + n] = static_cast<uint32_t>(top);
+    carry = static_cast<uint32_t>(top >> 32);
+  }
+  if (carry != 0 || compareLimbs(t + n, n, m, n) >= 0) {
+    subFrom(t + n, n, m, n);
+  }
+  std::copy_n(t + n, n, res);
+}
+
+// res[0, n) = x^e for e != 0, left to right over sliding windows of e's bits with mul(res, a, b) on n-limb values,
+// which has to allow res to alias a or b. Only the odd powers of x below 2^window are tabulated.
+template <class Mul>
+void windowPow(uint32_t* res, const uint32_t* x, size_t n, const uint32_t* e, size_t e_size, Mul mul) {
+  size_t bits = 32 * e_size - std::countl_zero(e[e_size - 1]);
+  size_t window = bits > 671 ? 6 : bits > 239 ? 5 : bits > 79 ? 4 : bits > 23 ? 3 : bits > 6 ? 2 : 1;
+  auto bit = [e](size_t i) { return (e[i / 32] >> (i % 32)) & 1; };
+
+  size_t table_size = size_t(1) << (window - 1);
+  scratch_buffer table(table_size * n);
+  std::copy_n(x, n, table.data());
+  if (table_size > 1) {
+    scratch_buffer square(n);
+    mul(square.data(), x, x);
+    for (size_t i = 1; i < table_size; i++) {
+      mul(table.data() + i * n, table.data() + (i - 1) * n, square.data());
     }
   }
-  zeroResult();
-  return *this;
-}
 
-big_integer big_integer::operator--(int) {
-  big_integer tmp(*this);
-  --(*this);
-  return tmp;
+  bool started = false;
+  for (size_t i = bits; i > 0;) {
+    if (bit(i - 1) == 0) {
+      mul(res, res, res);
+      i--;
+      continue;
+    }
+    size_t low = i > window ? i - window : 0;
+    while (bit(low) == 0) {
+      low++;
+    }
+    size_t value = 0;
+    for (size_t j = i; j-- > low;) {
+      value = value << 1 | bit(j);
+    }
+    const uint32_t* power = table.data() + (value >> 1) * n;
+    if (started) {
+      for (size_t j = low; j < i; j++) {
+        mul(res, res, res);
+      }
+      mul(res, res, power);
+    } else {
+      std::copy_n(power, n, res);
+      started = true;
+    }
+    i = low;
+  }
 }
-
-big_integer operator+(const big_integer& a, const big_integer& b) {
-  return big_integer(a) += b;
+} // namespace
+
+// Powers modulo 2^bits only need the low bits of each product.
+big_integer big_integer::powModPowerOfTwo(const big_integer& base, const big_integer& exp, size_t bits) {
+  size_t n = (bits + 31) / 32;
+  uint32_t top_mask = bits % 32 == 0 ? UINT32_MAX : (uint32_t(1) << (bits % 32)) - 1;
+  auto mul = [n, top_mask](uint32_t* res, const uint32_t* a, const uint32_t* b) {
+    scratch_buffer t(2 * n);
+    mulLimbs(t.data(), a, n, b, n);
+    std::copy_n(t.data(), n, res);
+    res[n - 1] &= top_mask;
+  };
+
+  big_integer mask = 1;
+  shift_left(mask, bits);
+  --mask;
+  big_integer x = base & mask;
+  x._data.resize(n);
+
+  big_integer res;
+  res._data.resize(n);
+  windowPow(res._data.data(), x._data.data(), n, exp._data.data(), exp._data.size(), mul);
+  res.trim();
+  return res;
 }
 
-big_integer operator-(const big_integer& a, const big_integer& b) {
-  return big_integer(a) -= b;
+// An even modulus splits into 2^s * q with q odd; the two residues are combined with Garner's formula
+// x = x_q + q * ((x_2 - x_q) * q^(-1) mod 2^s), the inverse coming from Newton's iteration modulo 2^s.
+big_integer pow_mod(const big_integer& base, const big_integer& exp, const big_integer& mod) {
+  if (mod.isZero()) {
+    throw std::runtime_error("Runtime error: division by zero");
+  }
+  if (exp._sign) {
+    throw std::invalid_argument("Invalid argument: negative exponent");
+  }
+  big_integer m = mod;
+  m._sign = false;
+  if (exp.isZero()) {
+    return big_integer(1) % m;
+  }
+  size_t zero_limbs = 0;
+  while (m._data[zero_limbs] == 0) {
+    zero_limbs++;
+  }
+  size_t s = 32 * zero_limbs + std::countr_zero(m._data[zero_limbs]);
+  if (s == 0) {
+    return modulus_context(m).pow_mod(base, exp);
+  }
+  big_integer low = big_integer::powModPowerOfTwo(base, exp, s);
+  big_integer q = std::move(m);
+  shift_right(q, s);
+  if (q == 1) {
+    return low;
+  }
+  big_integer high = modulus_context(q).pow_mod(base, exp);
+  big_integer mask = 1;
+  shift_left(mask, s);
+  --mask;
+  big_integer inverse = inverseLimb(q._data[0]);
+  for (size_t precision = 32; precision < s; precision *= 2) {
+    inverse = (inverse * (2 - q * inverse)) & mask;
+  }
+  inverse &= mask;
+  return high + q * (((low - high) * inverse) & mask);
 }
 
-big_integer operator*(const big_integer& a, const big_integer& b) {
-  return big_integer(a) *= b;
+namespace {
+// floor(a / 2^shift) for a value that fits in 64 bits after the shift.
+uint64_t topBits(const uint32_t* a, size_t size, size_t shift) {
+  size_t limb = shift / 32;
+  if (limb >= size) {
+    return 0;
+  }
+  int bit = static_cast<int>(shift % 32);
+  uint64_t low = a[limb] | (limb + 1 < size ? static_cast<uint64_t>(a[limb + 1]) << 32 : 0);
+  uint64_t high = limb + 2 < size ? a[limb + 2] : 0;
+  return bit == 0 ? low : low >> bit | high << (64 - bit);
 }
 
-big_integer operator/(const big_integer& a, const big_integer& b) {
-  return big_integer(a) /= b;
+// res[0, size) = x * a + y * b for cofactors of opposite signs (or one of them zero) below 2^32 in magnitude, when the
+// result is known to be non-negative and to fit.
+void combineLimbs(uint32_t* res, const uint32_t* a, const uint32_t* b, size_t size, int64_t x, int64_t y) {
+  if (y <= 0) {
+    mulDigit(res, a, size, static_cast<uint32_t>(x));
+    subMulDigit(res, b, size, static_cast<uint32_t>(-y));
+  } else {
+    mulDigit(res, b, size, static_cast<uint32_t>(y));
+    subMulDigit(res, a, size, static_cast<uint32_t>(-x));
+  }
 }
+} // namespace
+
+// Lehmer's algorithm (Knuth 4.5.2 L) on |a| and |b|: Euclid runs on the leading 62 bits of both with a cofactor matrix
+// while its quotients are provably the true ones, and the matrix is then applied to the full numbers in one pass. A
+// division step is only taken when the leading bits give no quotient, typically when the sizes differ. Single-word
+// tails finish with a binary gcd. With cofactor != nullptr it also yields s with s * |a| == gcd (mod |b|).
+big_integer big_integer::gcdCore(big_integer a, big_integer b, big_integer* cofactor) {
+  a._sign = false;
+  b._sign = false;
+  big_integer s_a = 1;
+  big_integer s_b = 0;
+  if (a < b) {
+    a.swap(b);
+    s_a.swap(s_b);
+  }
+  while (!b.isZero()) {
+    size_t size = a._data.size();
+    if (cofactor == nullptr && size <= 2) {
+      uint64_t x = topBits(a._data.data(), size, 0);
+      uint64_t y = topBits(b._data.data(), b._data.size(), 0);
+      return std::gcd(x, y);
+    }
+    size_t bits = 32 * size - std::countl_zero(a._data.back());
+    size_t shift = bits > 62 ? bits - 62 : 0;
+    auto ah = static_cast<int64_t>(topBits(a._data.data(), size, shift));
+    auto bh = static_cast<int64_t>(topBits(b._data.data(), b._data.size(), shift));
+    int64_t x_a = 1;
+    int64_t y_a = 0;
+    int64_t x_b = 0;
+    int64_t y_b = 1;
+    while (bh + x_b != 0 && bh + y_b != 0) {
+      int64_t q = (ah + x_a) / (bh + x_b);
+      if (q != (ah + y_a) / (bh + y_b)) {
+        break;
+      }
+      int64_t next_x = x_a - q * x_b;
+      int64_t next_y = y_a - q * y_b;
+      if (next_x <= -(int64_t(1) << 32) || next_x >= int64_t(1) << 32 || next_y <= -(int64_t(1) << 32) ||
+          next_y >= int64_t(1) << 32) {
+        break;
+      }
+      x_a = std::exchange(x_b, next_x);
+      y_a = std::exchange(y_b, next_y);
+      ah = std::exchange(bh, ah - q * bh);
+    }
 
-big_integer operator%(const big_integer& a, const big_integer& b) {
-  return big_integer(a) %= b;
+    if (y_a == 0) {
+      big_integer q;
+      big_integer r;
+      divmod(a, b, q, r);
+      a.swap(b);
+      b.swap(r);
+      if (cofactor != nullptr) {
+        s_a -= q * s_b;
+        s_a.swap(s_b);
+      }
+      continue;
+    }
+    b._data.resize(size);
+    scratch_buffer next_a(size);
+    scratch_buffer next_b(size);
+    combineLimbs(next_a.data(), a._data.data(), b._data.data(), size, x_a, y_a);
+    combineLimbs(next_b.data(), a._data.data(), b._data.data(), size, x_b, y_b);
+    std::copy_n(next_a.data(), size, a._data.data());
+    std::copy_n(next_b.data(), size, b._data.data());
+    a.trim();
+    b.trim();
+    if (cofactor != nullptr) {
+      big_integer next_s = s_a * x_a + s_b * y_a;
+      s_b = s_a * x_b + s_b * y_b;
+      s_a.swap(next_s);
+    }
+  }
+  if (cofactor != nullptr) {
+    *cofactor = std::move(s_a);
+  }
+  return a;
 }
 
-big_integer operator&(const big_integer& a, const big_integer& b) {
-  return big_integer(a) &= b;
+big_integer gcd(const big_integer& a, const big_integer& b) {
+  return big_integer::gcdCore(a, b, nullptr);
 }
 
-big_integer operator|(const big_integer& a, const big_integer& b) {
-  return big_integer(a) |= b;
+big_integer lcm(const big_integer& a, const big_integer& b) {
+  if (a.isZero() || b.isZero()) {
+    return 0;
+  }
+  big_integer res = a / gcd(a, b) * b;
+  res._sign = false;
+  return res;
 }
 
-big_integer operator^(const big_integer& a, const big_integer& b) {
-  return big_integer(a) ^= b;
+big_integer extended_gcd(const big_integer& a, const big_integer& b, big_integer& x, big_integer& y) {
+  big_integer s;
+  big_integer g = big_integer::gcdCore(a, b, &s);
+  if (a._sign) {
+    s = -std::move(s);
+  }
+  if (b.isZero()) {
+    y = 0;
+  } else {
+    y = (g - a * s) / b;
+  }
+  x = std::move(s);
+  return g;
 }
 
-big_integer operator<<(const big_integer& a, int b) {
-  return big_integer(a) <<= b;
+big_integer mod_inverse(const big_integer& a, const big_integer& mod) {
+  if (mod.isZero()) {
+    throw std::runtime_error("Runtime error: division by zero");
+  }
+  big_integer s;
+  if (big_integer::gcdCore(a, mod, &s) != 1) {
+    throw std::invalid_argument("Invalid argument: not invertible");
+  }
+  if (a._sign) {
+    s = -std::move(s);
+  }
+  big_integer m = mod;
+  m._sign = false;
+  s %= m;
+  if (s._sign) {
+    s += m;
+  }
+  return s;
 }
 
-big_integer operator>>(const big_integer& a, int b) {
-  return big_integer(a) >>= b;
-}
+// Left to right over sliding windows of exp's bits, ping-ponging between two buffers sized for the result up front.
+// Factors of two in the base become a shift, and single-limb powers in the window table are applied with mulDigit.
+big_integer pow(const big_integer& base, uint64_t exp) {
+  if (exp == 0) {
+    return 1;
+  }
+  if (base.isZero()) {
+    return 0;
+  }
+  size_t zero_limbs = 0;
+  while (base._data[zero_limbs] == 0) {
+    zero_limbs++;
+  }
+  size_t twos = 32 * zero_limbs + std::countr_zero(base._data[zero_limbs]);
+  big_integer x = base;
+  x._sign = false;
+  shift_right(x, twos);
+  size_t x_bits = 32 * x._data.size() - std::countl_zero(x._data.back());
+  size_t factor_bits = (x_bits > 1 ? x_bits : 0) + twos;
+  if (factor_bits != 0 && exp > (std::numeric_limits<size_t>::max() - 64) / factor_bits) {
+    throw std::length_error("Length error: power too large");
+  }
+  size_t capacity = (factor_bits * exp + 32) / 32 + 1;
+
+  big_integer res;
+  res._data.resize(capacity);
+  res._data[0] = 1;
+  size_t size = 1;
+  if (x_bits > 1) {
+    int bits = 64 - std::countl_zero(exp);
+    int window = bits > 23 ? 4 : bits > 6 ? 3 : bits > 2 ? 2 : 1;
+    std::vector<big_integer> table(size_t(1) << (window - 1), x);
+    big_integer x_squared = sqr(x);
+    for (size_t i = 1; i < table.size(); i++) {
+      table[i] = table[i - 1] * x_squared;
+    }
 
-bool operator==(const big_integer& a, const big_integer& b) {
-  return a._sign == b._sign && a._data == b._data;
+    limb_vector other(capacity);
+    auto square = [&] {
+      sqrLimbs(other.data(), res._data.data(), size);
+      res._data.swap(other);
+      size = significantSize(res._data.data(), 2 * size);
+    };
+    auto multiply = [&](const big_integer& power) {
+      if (power._data.size() == 1) {
+        res._data[size] = mulDigit(res._data.data(), res._data.data(), size, power._data[0]);
+        size = significantSize(res._data.data(), size + 1);
+      } else {
+        mulLimbs(other.data(), res._data.data(), size, power._data.data(), power._data.size());
+        res._data.swap(other);
+        size = significantSize(res._data.data(), size + power._data.size());
+      }
+    };
+    bool started = false;
+    for (int i = bits; i > 0;) {
+      if (((exp >> (i - 1)) & 1) == 0) {
+        square();
+        i--;
+        continue;
+      }
+      int low = std::max(i - window, 0);
+      while (((exp >> low) & 1) == 0) {
+        low++;
+      }
+      for (int j = low; j < i && started; j++) {
+        square();
+      }
+      multiply(table[(exp >> low & ((uint64_t(1) << (i - low)) - 1)) >> 1]);
+      started = true;
+      i = low;
+    }
+  }
+  res._data.resize(size);
+  res._sign = base._sign && exp % 2 == 1;
+  shift_left(res, twos * exp);
+  return res;
 }
 
-bool operator!=(const big_integer& a, const big_integer& b) = default;
-
-bool operator<(const big_integer& a, const big_integer& b) {
-  if (a._sign != b._sign) {
-    return a._sign;
+// floor(n^(1/k)) for n >= 0. The root of n / 2^(k * j) is taken recursively and lifted to the overestimate
+// x = (r + 1) * 2^j, whose error is at most 2^j; j is chosen so that one Newton step from x lands within 1/2 of the
+// root, leaving a single correction. Roots of up to 32 bits start from a floating-point estimate of the top limbs.
+// With power != nullptr it also yields the k-th power of the result.
+big_integer big_integer::rootCore(const big_integer& n, uint32_t k, big_integer* power) {
+  size_t bits = n.isZero() ? 0 : 32 * n._data.size() - std::countl_zero(n._data.back());
+  if (bits <= k) {
+    // n < 2^k, so the root is 0 or 1.
+    big_integer x = bits == 0 ? 0 : 1;
+    if (power != nullptr) {
+      *power = x;
+    }
+    return x;
+  }
+  big_integer x;
+  if ((bits - 1) / k < 32) {
+    size_t top = std::min<size_t>(n._data.size(), 3);
+    double head = 0;
+    for (size_t i = 0; i < top; i++) {
+      head = head * 4294967296.0 + n._data[n._data.size() - 1 - i];
+    }
+    double log = std::log2(head) + 32.0 * static_cast<double>(n._data.size() - top);
+    uint64_t root = static_cast<uint64_t>(std::exp2(log / k));
+    // Whether y^k > n, settled by bit lengths unless y^k is within a bit of n, so that a large k never builds a
+    // power much longer than n.
+    auto exceeds = [&](uint64_t y) {
+      uint64_t width = std::bit_width(y);
+      if (k * (width - 1) >= bits) {
+        return true;
+      }
+      if (k * width < bits) {
+        return false;
+      }
+      return pow(big_integer(y), k) > n;
+    };
+    while (root > 1 && exceeds(root)) {
+      root--;
+    }
+    while (!exceeds(root + 1)) {
+      root++;
+    }
+    x = root;
   } else {
-    if (!a._sign) {
-      return a.compareLessAbs(b);
+    size_t j = std::max<size_t>(((bits - 1) / k - std::bit_width(k - 1)) / 2, 1);
+    big_integer head = n;
+    shift_right(head, k * j);
+    x = rootCore(head, k, nullptr) + 1;
+    shift_left(x, j);
+    if (k == 2) {
+      x += n / x;
+      x >>= 1;
     } else {
-      return b.compareLessAbs(a);
+      big_integer next = n / pow(x, k - 1);
+      addmul(next, x, k - 1);
+      x = next / k;
     }
   }
+  big_integer p = k == 2 ? sqr(x) : pow(x, k);
+  while (p > n) {
+    x -= 1;
+    p = pow(x, k);
+  }
+  if (power != nullptr) {
+    *power = std::move(p);
+  }
+  return x;
 }
 
-bool operator>(const big_integer& a, const big_integer& b) {
-  return b < a;
+big_integer isqrt(const big_integer& n) {
+  if (n._sign) {
+    throw std::invalid_argument("Invalid argument: negative radicand");
+  }
+  return big_integer::rootCore(n, 2, nullptr);
 }
 
-bool operator<=(const big_integer& a, const big_integer& b) {
-  return !(a > b);
+std::pair<big_integer, big_integer> isqrt_rem(const big_integer& n) {
+  if (n._sign) {
+    throw std::invalid_argument("Invalid argument: negative radicand");
+  }
+  big_integer square;
+  big_integer root = big_integer::rootCore(n, 2, &square);
+  return {std::move(root), n - square};
 }
 
-bool operator>=(const big_integer& a, const big_integer& b) {
-  return !(a < b);
+big_integer iroot(const big_integer& n, uint32_t k) {
+  if (k == 0) {
+    throw std::invalid_argument("Invalid argument: zeroth root");
+  }
+  if (n._sign && k % 2 == 0) {
+    throw std::invalid_argument("Invalid argument: negative radicand");
+  }
+  big_integer abs = n;
+  abs._sign = false;
+  big_integer root = k == 1 ? std::move(abs) : big_integer::rootCore(abs, k, nullptr);
+  if (n._sign) {
+    root = -std::move(root);
+  }
+  return root;
 }
 
-std::string to_string(const big_integer& a) {
-  if (a.isZero()) {
-    return "0";
+namespace {
+// Primes up to n from a sieve of Eratosthenes over the odd numbers.
+std::vector<uint64_t> primesUpTo(uint64_t n) {
+  std::vector<uint64_t> primes;
+  if (n < 2) {
+    return primes;
   }
-  std::string result;
-  big_integer tmp(a);
-  while (!tmp.isZero()) {
-    uint32_t rem = tmp.singleWordDiv(1000000000);
-    size_t len = 9;
-    while (rem != 0) {
-      result += (rem % 10 + '0');
-      rem /= 10;
-      len--;
+  primes.push_back(2);
+  std::vector<bool> composite((n - 1) / 2);
+  for (size_t i = 0; i < composite.size(); i++) {
+    if (composite[i]) {
+      continue;
     }
-    if (!tmp.isZero()) {
-      result.insert(result.end(), len, '0');
+    uint64_t p = 2 * i + 3;
+    primes.push_back(p);
+    for (uint64_t j = (p * p - 3) / 2; j < composite.size(); j += p) {
+      composite[j] = true;
     }
   }
-  if (a._sign) {
-    result += "-";
+  return primes;
+}
+
+// Product of [first, last) by balanced halving, so that the large products are between operands of equal size. Short
+// runs are packed into 64-bit words first.
+big_integer productOf(const uint64_t* first, const uint64_t* last) {
+  if (last - first > 16) {
+    const uint64_t* middle = first + (last - first) / 2;
+    return productOf(first, middle) * productOf(middle, last);
   }
-  std::reverse(result.begin(), result.end());
-  return result;
+  big_integer res = 1;
+  uint64_t word = 1;
+  for (; first != last; ++first) {
+    if (word > std::numeric_limits<uint64_t>::max() / *first) {
+      res *= word;
+      word = 1;
+    }
+    word *= *first;
+  }
+  return res *= word;
 }
 
-big_integer big_integer::bigDivision(const big_integer& rhs) {
-  if (rhs.isZero()) {
-    throw std::runtime_error("Runtime error: division by zero");
+// Exponent of p in n!, by Legendre's formula.
+uint64_t factorialExponent(uint64_t n, uint64_t p) {
+  uint64_t res = 0;
+  while (n >= p) {
+    n /= p;
+    res += n;
   }
+  return res;
+}
 
-  if (this->compareLessAbs(rhs)) {
-    big_integer tmp;
-    swap(tmp);
-    return tmp;
+// The product of primes[i]^exponents[i]. Bit b of every odd prime's exponent puts the prime into the group P_b, and
+// the groups are combined as ((P_top^2 * P_top-1)^2 * ...) * P_0, so each group is one balanced product tree and the
+// prime powers are never formed. The power of two is a final shift.
+big_integer primePowerProduct(const std::vector<uint64_t>& primes, const std::vector<uint64_t>& exponents) {
+  uint64_t all_bits = 0;
+  for (size_t i = 1; i < primes.size(); i++) {
+    all_bits |= exponents[i];
   }
-  big_integer b(rhs);
-  bool save_sign = _sign;
-  b._sign = false;
-  _sign = false;
-  int k = 0;
-  while (b._data.back() < base / 2) {
-    b <<= 1;
-    k++;
-  }
-  (*this) <<= k;
-  size_t m = _data.size() - rhs._data.size();
-  std::vector<uint32_t> save_b_data = b._data;
-  b._data.insert(b._data.begin(), m, 0);
-  std::vector<uint32_t> res(m + 1, 0);
-  if (*this >= b) {
-    res[m] = 1;
-    *this -= b;
-  }
-  for (std::ptrdiff_t i = m - 1; i >= 0; i--) {
-    b._data.erase(b._data.begin());
-    uint64_t div;
-    if (save_b_data.size() + i - 1 >= _data.size()) {
-      div = 0;
-    } else if (save_b_data.size() + i >= _data.size()) {
-      div = _data[save_b_data.size() + i - 1] / save_b_data.back();
-    } else {
-      div = (_data[save_b_data.size() + i] * base + _data[save_b_data.size() + i - 1]) / save_b_data.back();
-    }
-    res[i] = std::min(div, base - 1);
-    *this -= b * res[i];
-    while (*this < 0) {
-      res[i]--;
-      *this += b;
+  big_integer res = 1;
+  std::vector<uint64_t> group;
+  for (int bit = 63 - std::countl_zero(all_bits | 1); bit >= 0; bit--) {
+    res = sqr(res);
+    group.clear();
+    for (size_t i = 1; i < primes.size(); i++) {
+      if ((exponents[i] >> bit) & 1) {
+        group.push_back(primes[i]);
+      }
     }
+    res *= productOf(group.data(), group.data() + group.size());
   }
-  trim();
-  singleWordDiv(static_cast<uint32_t>(1) << k);
-  big_integer rem;
-  swap(rem);
-  rem._sign = save_sign;
-  std::swap(_data, res);
-  trim();
-  _sign = save_sign ^ rhs._sign;
-  return rem;
+  if (!primes.empty()) {
+    shift_left(res, exponents[0]);
+  }
+  return res;
 }
+} // namespace
 
-void big_integer::mulDigitAbs(uint32_t b) {
-  _data.insert(_data.begin(), 1, 0);
+big_integer factorial(uint64_t n) {
+  std::vector<uint64_t> primes = primesUpTo(n);
+  std::vector<uint64_t> exponents(primes.size());
+  for (size_t i = 0; i < primes.size(); i++) {
+    exponents[i] = factorialExponent(n, primes[i]);
+  }
+  return primePowerProduct(primes, exponents);
+}
 
-  for (size_t i = 0; i < _data.size() - 1; i++) {
-    uint64_t cur = _data[i] + static_cast<uint64_t>(_data[i + 1]) * b;
-    _data[i] = static_cast<uint32_t>(cur % base);
-    _data[i + 1] = static_cast<uint32_t>(cur / base);
+// Far from the middle the quotient of the top k factors by k! is cheaper than sieving up to n.
+big_integer binomial(uint64_t n, uint64_t k) {
+  if (k > n) {
+    return 0;
   }
-  trim();
+  k = std::min(k, n - k);
+  if (k <= n / 16) {
+    std::vector<uint64_t> factors(k);
+    std::iota(factors.begin(), factors.end(), n - k + 1);
+    return productOf(factors.data(), factors.data() + k) / factorial(k);
+  }
+  std::vector<uint64_t> primes = primesUpTo(n);
+  std::vector<uint64_t> exponents(primes.size());
+  for (size_t i = 0; i < primes.size(); i++) {
+    exponents[i] =
+        factorialExponent(n, primes[i]) - factorialExponent(k, primes[i]) - factorialExponent(n - k, primes[i]);
+  }
+  return primePowerProduct(primes, exponents);
 }
 
-void big_integer::mulAbs(const big_integer& b) {
-  size_t save_size = _data.size();
-  _data.insert(_data.begin(), b._data.size(), 0);
+big_integer primorial(uint64_t n) {
+  std::vector<uint64_t> primes = primesUpTo(n);
+  return productOf(primes.data(), primes.data() + primes.size());
+}
 
-  for (size_t i = 0; i < save_size; i++) {
-    uint32_t carry = 0;
-    for (size_t j = 0; j < b._data.size(); j++) {
-      uint64_t cur = _data[i + j] + static_cast<uint64_t>(_data[i + b._data.size()]) * b._data[j] + carry;
-      _data[i + j] = static_cast<uint32_t>(cur % base);
-      carry = static_cast<uint32_t>(cur / base);
+namespace {
+// The first 255 odd primes, up to 1619, for trial division and for sieving candidates.
+constexpr std::array<uint32_t, 255> SMALL_PRIMES = [] {
+  std::array<uint32_t, 255> primes{};
+  size_t count = 0;
+  for (uint32_t candidate = 3; count < primes.size(); candidate += 2) {
+    bool prime = true;
+    for (size_t i = 0; i < count && primes[i] * primes[i] <= candidate; i++) {
+      prime = prime && candidate % primes[i] != 0;
+    }
+    if (prime) {
+      primes[count++] = candidate;
     }
-    _data[i + b._data.size()] = carry;
   }
-  trim();
-}
+  return primes;
+}();
 
-void big_integer::subDigitAbs(uint32_t b) {
-  uint32_t carry_flag = b;
+// Without a factor among SMALL_PRIMES, anything below this is prime.
+constexpr uint64_t SMALL_PRIMES_SQUARED = uint64_t(1619) * 1619;
 
-  for (int i = 0; i < _data.size(); ++i) {
-    int64_t value = static_cast<int64_t>(_data[i]) - carry_flag;
-    if (value < 0) {
-      value += base;
-      carry_flag = true;
-    } else {
-      carry_flag = false;
-    }
-    _data[i] = value;
+uint32_t remLimb(const uint32_t* a, size_t size, uint32_t d) {
+  uint64_t rem = 0;
+  for (size_t i = size; i-- > 0;) {
+    rem = (rem << 32 | a[i]) % d;
   }
-  trim();
+  return static_cast<uint32_t>(rem);
 }
 
-void big_integer::subAbs(big_integer& res, const big_integer& b) const {
-  bool carry_flag = false;
+// res[i] = a mod SMALL_PRIMES[i]. The primes are taken in groups whose product fits in a limb, so that there is one
+// pass over a per group.
+void smallPrimeResidues(const uint32_t* a, size_t size, uint32_t* res) {
+  for (size_t first = 0; first < SMALL_PRIMES.size();) {
+    uint64_t product = SMALL_PRIMES[first];
+    size_t last = first + 1;
+    while (last < SMALL_PRIMES.size() && product * SMALL_PRIMES[last] <= UINT32_MAX) {
+      product *= SMALL_PRIMES[last++];
+    }
+    uint32_t rem = remLimb(a, size, static_cast<uint32_t>(product));
+    for (; first < last; first++) {
+      res[first] = rem % SMALL_PRIMES[first];
+    }
+  }
+}
 
-  int maxSize = std::max(_data.size(), b._data.size());
-  res.stretch(maxSize);
+// Jacobi symbol (a / m) for odd m.
+int jacobiSymbol(uint32_t a, uint32_t m) {
+  int res = 1;
+  a %= m;
+  while (a != 0) {
+    while (a % 2 == 0) {
+      a /= 2;
+      if (m % 8 == 3 || m % 8 == 5) {
+        res = -res;
+      }
+    }
+    std::swap(a, m);
+    if (a % 4 == 3 && m % 4 == 3) {
+      res = -res;
+    }
+    a %= m;
+  }
+  return m == 1 ? res : 0;
+}
 
-  for (int i = 0; i < maxSize; ++i) {
-    int64_t value = static_cast<int64_t>(_data[i]) - (i < b._data.size() ? b._data[i] : 0) - carry_flag;
-    if (value < 0) {
-      value += base;
-      carry_flag = true;
-    } else {
-      carry_flag = false;
+// Strong probable-prime test of n = context.modulus() to base a, where n - 1 = d * 2^s with d odd.
+bool strongProbablePrime(const modulus_context& context, const big_integer& a, const big_integer& d, size_t s) {
+  big_integer n_minus_one = context.modulus() - 1;
+  big_integer x = context.pow_mod(a, d);
+  if (x == 1 || x == n_minus_one) {
+    return true;
+  }
+  for (size_t i = 1; i < s; i++) {
+    context.sqr_mod(x, x);
+    if (x == n_minus_one) {
+      return true;
+    }
+    if (x == 1) {
+      return false;
     }
-    res._data[i] = value;
   }
-  res.trim();
+  return false;
 }
+} // namespace
+
+// Strong Lucas test with Selfridge's parameters: D is the first of 5, -7, 9, -11, ... with (D / n) == -1, P = 1 and
+// Q = (1 - D) / 4. As D == 1 (mod 4), (D / n) == (n mod |D| / |D|). A square n has no such D, so squares are ruled
+// out once the search gets past 13. U and V run through the binary digits of (n + 1) / 2^s in Montgomery form, using
+// U_2k = U_k V_k, V_2k = V_k^2 - 2 Q^k and the halvings (U + V) / 2, (D U + V) / 2 for the step to k + 1; the small
+// factors D and Q are applied by doubling and adding. The modulus is odd and has no factor among SMALL_PRIMES.
+bool modulus_context::strongLucasTest() const {
+  size_t n = _modulus._data.size();
+  const uint32_t* m = _modulus._data.data();
+  int64_t d = 5;
+  while (true) {
+    auto abs_d = static_cast<uint32_t>(d > 0 ? d : -d);
+    int symbol = jacobiSymbol(remLimb(m, n, abs_d), abs_d);
+    if (symbol == -1) {
+      break;
+    }
+    if (symbol == 0 && _modulus != abs_d) {
+      return false;
+    }
+    if (abs_d == 13 && isqrt_rem(_modulus).second.isZero()) {
+      return false;
+    }
+    d = d > 0 ? -d - 2 : -d + 2;
+  }
 
-void big_integer::sumDigitAbs(uint32_t b) {
-  uint32_t flag_over = b;
-  for (int i = 0; i < _data.size(); ++i) {
-    uint64_t value = static_cast<uint64_t>(_data[i]) + flag_over;
-    flag_over = value >= base;
-    if (flag_over) {
-      value -= base;
+  uint64_t m_inv = _montgomery_inverse;
+  auto mul = [m, n, m_inv](uint32_t* res, const uint32_t* a, const uint32_t* b) {
+    scratch_buffer t(2 * n);
+    mulLimbs(t.data(), a, n, b, n);
+    montgomeryReduce(res, t.data(), m, n, m_inv);
+  };
+  auto add = [m, n](uint32_t* res, const uint32_t* a, const uint32_t* b) {
+    if (addLimbs(res, a, n, b, n) != 0 || compareLimbs(res, n, m, n) >= 0) {
+      subFrom(res, n, m, n);
     }
-    _data[i] = value;
+  };
+  auto halve = [m, n](uint32_t* a) {
+    uint32_t carry = (a[0] & 1) != 0 ? addTo(a, n, m, n) : 0;
+    shiftRightLimbs(a, a, n, 1);
+    a[n - 1] |= carry << 31;
+  };
+  scratch_buffer factor(n);
+  auto scale = [m, n, &add, &factor](uint32_t* a, int64_t c) {
+    std::copy_n(a, n, factor.data());
+    auto abs_c = static_cast<uint32_t>(c > 0 ? c : -c);
+    for (int bit = 30 - std::countl_zero(abs_c); bit >= 0; bit--) {
+      add(a, a, a);
+      if ((abs_c >> bit) & 1) {
+        add(a, a, factor.data());
+      }
+    }
+    if (c < 0 && significantSize(a, n) != 0) {
+      subLimbs(a, m, n, a, n);
+    }
+  };
+
+  int64_t q = (1 - d) / 4;
+  scratch_buffer u(n);
+  scratch_buffer v(n);
+  scratch_buffer q_k(n);
+  scratch_buffer next_u(n);
+  residue(u.data(), 1);
+  mul(u.data(), u.data(), _r_squared._data.data());
+  std::copy_n(u.data(), n, v.data());
+  std::copy_n(u.data(), n, q_k.data());
+  scale(q_k.data(), q);
+  auto double_v = [&] {
+    mul(v.data(), v.data(), v.data());
+    for (int i = 0; i < 2; i++) {
+      if (subLimbs(v.data(), v.data(), n, q_k.data(), n) != 0) {
+        addTo(v.data(), n, m, n);
+      }
+    }
+    mul(q_k.data(), q_k.data(), q_k.data());
+  };
+
+  big_integer k = _modulus + 1;
+  size_t s = 0;
+  while (k._data[s / 32] == 0) {
+    s += 32;
   }
-  if (flag_over) {
-    _data.push_back(flag_over);
+  s += std::countr_zero(k._data[s / 32]);
+  shift_right(k, s);
+  for (size_t bit = 32 * k._data.size() - std::countl_zero(k._data.back()) - 1; bit-- > 0;) {
+    mul(u.data(), u.data(), v.data());
+    double_v();
+    if ((k._data[bit / 32] >> (bit % 32)) & 1) {
+      add(next_u.data(), u.data(), v.data());
+      halve(next_u.data());
+      scale(u.data(), d);
+      add(v.data(), v.data(), u.data());
+      halve(v.data());
+      std::copy_n(next_u.data(), n, u.data());
+      scale(q_k.data(), q);
+    }
+  }
+  if (significantSize(u.data(), n) == 0 || significantSize(v.data(), n) == 0) {
+    return true;
+  }
+  for (size_t r = 1; r < s; r++) {
+    double_v();
+    if (significantSize(v.data(), n) == 0) {
+      return true;
+    }
   }
+  return false;
 }
 
-void big_integer::sumAbs(const big_integer& b) {
-  bool flag_over = false;
+// Baillie-PSW on an odd n without a factor among SMALL_PRIMES: a strong probable-prime test to base 2 and a strong
+// Lucas test, followed by rounds of Miller-Rabin to bases drawn from a generator seeded with n.
+bool big_integer::probablePrimeCore(const big_integer& n, unsigned rounds) {
+  modulus_context context(n);
+  big_integer d = n - 1;
+  size_t s = 0;
+  while (d._data[s / 32] == 0) {
+    s += 32;
+  }
+  s += std::countr_zero(d._data[s / 32]);
+  shift_right(d, s);
+  if (!strongProbablePrime(context, 2, d, s) || !context.strongLucasTest()) {
+    return false;
+  }
+  std::mt19937_64 random(n._data[0]);
+  big_integer range = n - 3;
+  for (unsigned i = 0; i < rounds; i++) {
+    big_integer a;
+    a._data.resize(n._data.size());
+    std::generate(a._data.begin(), a._data.end(), [&random] { return static_cast<uint32_t>(random()); });
+    a.trim();
+    if (!strongProbablePrime(context, a % range + 2, d, s)) {
+      return false;
+    }
+  }
+  return true;
+}
 
-  stretch(b._data.size());
+bool is_probable_prime(const big_integer& n, unsigned rounds) {
+  if (n._sign || n.isZero() || (n._data.size() == 1 && n._data[0] < 4)) {
+    return n == 2 || n == 3;
+  }
+  if ((n._data[0] & 1) == 0) {
+    return false;
+  }
+  if (n._data.size() == 1 && n._data[0] <= SMALL_PRIMES.back()) {
+    return std::binary_search(SMALL_PRIMES.begin(), SMALL_PRIMES.end(), n._data[0]);
+  }
+  std::array<uint32_t, SMALL_PRIMES.size()> residues;
+  smallPrimeResidues(n._data.data(), n._data.size(), residues.data());
+  if (std::find(residues.begin(), residues.end(), 0) != residues.end()) {
+    return false;
+  }
+  return n < SMALL_PRIMES_SQUARED || big_integer::probablePrimeCore(n, rounds);
+}
 
-  for (int i = 0; i < _data.size(); ++i) {
-    uint64_t value = static_cast<uint64_t>(_data[i]) + (i < b._data.size() ? b._data[i] : 0) + flag_over;
-    flag_over = value >= base;
-    if (flag_over) {
-      value -= base;
+// Candidates above the table are sieved by SMALL_PRIMES through residues that are computed once and then advanced by
+// the offset, so only survivors of the sieve reach the Baillie-PSW test.
+big_integer next_prime(const big_integer& n) {
+  if (n < SMALL_PRIMES.back()) {
+    big_integer candidate = n < 2 ? 2 : n + 1;
+    while (!is_probable_prime(candidate)) {
+      candidate += 1;
     }
-    _data[i] = value;
+    return candidate;
   }
-  if (flag_over) {
-    _data.push_back(1);
+  big_integer candidate = n + 1;
+  if ((candidate._data[0] & 1) == 0) {
+    candidate += 1;
+  }
+  std::array<uint32_t, SMALL_PRIMES.size()> residues;
+  smallPrimeResidues(candidate._data.data(), candidate._data.size(), residues.data());
+  for (uint64_t offset = 0;; offset += 2) {
+    bool sieved = false;
+    for (size_t i = 0; i < SMALL_PRIMES.size() && !sieved; i++) {
+      sieved = (residues[i] + offset) % SMALL_PRIMES[i] == 0;
+    }
+    if (sieved) {
+      continue;
+    }
+    big_integer res = candidate + offset;
+    if (res < SMALL_PRIMES_SQUARED || big_integer::probablePrimeCore(res, 0)) {
+      return res;
+    }
   }
 }
 
-uint32_t big_integer::singleWordDiv(uint32_t b) {
-  if (b == 0) {
+modulus_context::modulus_context(const big_integer& modulus) : _modulus(modulus), _montgomery_inverse(0) {
+  if (modulus.isZero()) {
     throw std::runtime_error("Runtime error: division by zero");
   }
-  uint32_t carry = 0;
-  for (std::ptrdiff_t i = _data.size() - 1; i >= 0; i--) {
-    uint64_t cur = _data[i] + carry * base;
-    _data[i] = static_cast<uint32_t>(cur / b);
-    carry = static_cast<uint32_t>(cur % b);
-  }
-  trim();
-  if (isZero()) {
-    _sign = false;
+  _modulus._sign = false;
+  size_t n = _modulus._data.size();
+  big_integer power = 1;
+  shift_left(power, 64 * n);
+  _reciprocal = (power - 1) / _modulus;
+  _reciprocal._data.resize(n + 1);
+
+  const uint32_t* m = _modulus._data.data();
+  if (m[0] % 2 == 1) {
+    uint64_t m_low = n > 1 ? static_cast<uint64_t>(m[1]) << 32 | m[0] : m[0];
+    uint64_t inverse = inverseLimb(m[0]);
+    _montgomery_inverse = 0 - inverse * (2 - m_low * inverse);
+    reduce(power, _r_squared);
+    _r_squared._data.resize(n);
   }
-  return carry;
 }
 
-void big_integer::trim() {
-  while (!_data.empty() && _data.back() == 0) {
-    _data.pop_back();
+const big_integer& modulus_context::modulus() const {
+  return _modulus;
+}
+
+big_integer modulus_context::reduce(const big_integer& a) const {
+  big_integer res;
+  reduce(a, res);
+  return res;
+}
+
+void modulus_context::reduce(const big_integer& a, big_integer& res) const {
+  scratch_buffer r(_modulus._data.size());
+  residue(r.data(), a);
+  store(res, r.data());
+}
+
+big_integer modulus_context::add_mod(const big_integer& a, const big_integer& b) const {
+  big_integer res;
+  add_mod(a, b, res);
+  return res;
+}
+
+void modulus_context::add_mod(const big_integer& a, const big_integer& b, big_integer& res) const {
+  size_t n = _modulus._data.size();
+  scratch_buffer x(n + 1);
+  scratch_buffer y(n);
+  residue(x.data(), a);
+  residue(y.data(), b);
+  x[n] = addTo(x.data(), n, y.data(), n);
+  if (x[n] != 0 || compareLimbs(x.data(), n, _modulus._data.data(), n) >= 0) {
+    subFrom(x.data(), n + 1, _modulus._data.data(), n);
   }
+  store(res, x.data());
 }
 
-bool big_integer::isZero() const {
-  return _data.empty();
+big_integer modulus_context::mul_mod(const big_integer& a, const big_integer& b) const {
+  big_integer res;
+  mul_mod(a, b, res);
+  return res;
 }
 
-void big_integer::zeroResult() {
-  if (isZero()) {
-    _sign = false;
+void modulus_context::mul_mod(const big_integer& a, const big_integer& b, big_integer& res) const {
+  if (a.isZero() || b.isZero()) {
+    res = 0;
+    return;
   }
+  scratch_buffer product(a._data.size() + b._data.size());
+  mulLimbs(product.data(), a._data.data(), a._data.size(), b._data.data(), b._data.size());
+  scratch_buffer r(_modulus._data.size());
+  reduceLimbs(r.data(), product.data(), product.size(), a._sign != b._sign);
+  store(res, r.data());
 }
 
-void big_integer::swap(big_integer& other) {
-  std::swap(_data, other._data);
-  std::swap(_sign, other._sign);
+big_integer modulus_context::sqr_mod(const big_integer& a) const {
+  big_integer res;
+  sqr_mod(a, res);
+  return res;
 }
 
-void big_integer::stretch(size_t size) {
-  if (size > _data.size()) {
-    _data.resize(size, 0);
+void modulus_context::sqr_mod(const big_integer& a, big_integer& res) const {
+  scratch_buffer product(2 * a._data.size());
+  sqrLimbs(product.data(), a._data.data(), a._data.size());
+  scratch_buffer r(_modulus._data.size());
+  reduceLimbs(r.data(), product.data(), product.size(), false);
+  store(res, r.data());
+}
+
+// Odd moduli stay in Montgomery form for the whole ladder; even ones are split as in the free pow_mod.
+big_integer modulus_context::pow_mod(const big_integer& base, const big_integer& exp) const {
+  if (_montgomery_inverse == 0) {
+    return ::pow_mod(base, exp, _modulus);
+  }
+  if (exp._sign) {
+    throw std::invalid_argument("Invalid argument: negative exponent");
+  }
+  if (exp.isZero()) {
+    return reduce(1);
   }
+  size_t n = _modulus._data.size();
+  const uint32_t* m = _modulus._data.data();
+  uint64_t m_inv = _montgomery_inverse;
+  auto mul = [m, n, m_inv](uint32_t* res, const uint32_t* a, const uint32_t* b) {
+    scratch_buffer t(2 * n);
+    mulLimbs(t.data(), a, n, b, n);
+    montgomeryReduce(res, t.data(), m, n, m_inv);
+  };
+
+  scratch_buffer x(n);
+  residue(x.data(), base);
+  mul(x.data(), x.data(), _r_squared._data.data());
+  scratch_buffer power(2 * n);
+  windowPow(power.data(), x.data(), n, exp._data.data(), exp._data.size(), mul);
+  montgomeryReduce(x.data(), power.data(), m, n, m_inv);
+  big_integer res;
+  store(res, x.data());
+  return res;
 }
 
-uint32_t big_integer::singleTwoAddition(uint32_t digit, uint32_t& carry) {
-  uint64_t tmp = ~digit + static_cast<uint64_t>(carry);
-  carry = static_cast<uint32_t>(tmp / base);
-  return static_cast<uint32_t>(tmp % base);
+// One Barrett step (HAC 14.42) with mu = floor((B^2n - 1) / m): res[0, n) = x mod m for x[0, 2n). The quotient
+// estimate is at most a few units short, which the final subtractions make up for.
+void modulus_context::barrettStep(uint32_t* res, const uint32_t* x) const {
+  size_t n = _modulus._data.size();
+  const uint32_t* m = _modulus._data.data();
+  scratch_buffer quotient(2 * n + 2);
+  mulLimbs(quotient.data(), x + n - 1, n + 1, _reciprocal._data.data(), n + 1);
+  scratch_buffer modulus(n + 1);
+  std::copy_n(m, n, modulus.data());
+  scratch_buffer product(n + 1);
+  mulLowLimbs(product.data(), quotient.data() + n + 1, modulus.data(), n + 1);
+  scratch_buffer r(x, x + n + 1);
+  subFrom(r.data(), n + 1, product.data(), n + 1);
+  while (r[n] != 0 || compareLimbs(r.data(), n, m, n) >= 0) {
+    subFrom(r.data(), n + 1, m, n);
+  }
+  std::copy_n(r.data(), n, res);
 }
 
-bool big_integer::compareLessAbs(const big_integer& other) const {
-  if (isZero() && other.isZero()) {
-    return false;
+// res[0, n) = x mod m, or (-x) mod m when negative, taking in n more limbs of x per Barrett step.
+void modulus_context::reduceLimbs(uint32_t* res, const uint32_t* x, size_t size, bool negative) const {
+  size_t n = _modulus._data.size();
+  scratch_buffer block(2 * n);
+  size_t low = size > 2 * n ? size - 2 * n : 0;
+  std::copy(x + low, x + size, block.data());
+  barrettStep(res, block.data());
+  while (low > 0) {
+    size_t count = std::min(n, low);
+    low -= count;
+    std::fill(std::copy(x + low, x + low + count, block.data()), block.end(), 0);
+    std::copy_n(res, n, block.data() + count);
+    barrettStep(res, block.data());
   }
+  if (negative && significantSize(res, n) != 0) {
+    subLimbs(res, _modulus._data.data(), n, res, n);
+  }
+}
 
-  if (_data.size() != other._data.size()) {
-    return _data.size() < other._data.size();
+void modulus_context::residue(uint32_t* res, const big_integer& a) const {
+  size_t n = _modulus._data.size();
+  if (!a._sign && compareLimbs(a._data.data(), a._data.size(), _modulus._data.data(), n) < 0) {
+    std::fill(std::copy(a._data.begin(), a._data.end(), res), res + n, 0);
+  } else {
+    reduceLimbs(res, a._data.data(), a._data.size(), a._sign);
   }
+}
 
-  return std::lexicographical_compare(_data.rbegin(), _data.rend(), other._data.rbegin(), other._data.rend());
+void modulus_context::store(big_integer& res, const uint32_t* r) const {
+  res._data.assign(r, r + _modulus._data.size());
+  res._sign = false;
+  res.trim();
 }
 
 std::ostream& operator<<(std::ostream& out, const big_integer& a) {
@@ -1,16 +1,335 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <iosfwd>
 #include <iostream>
+#include <iterator>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+// Limb storage that keeps up to SMALL_SIZE limbs inside the object and moves to the heap only on growth. The first
+// heap buffer comes from the thread's big_integer_resource() at the time of the allocation; later buffers come from
+// the same resource, which also gets them back.
+class limb_vector {
+public:
+  using iterator = uint32_t*;
+  using const_iterator = const uint32_t*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+  using value_type = uint32_t;
+
+  static constexpr size_t SMALL_SIZE = 4;
+
+  limb_vector() noexcept : _size(0), _capacity(SMALL_SIZE), _resource(nullptr) {}
+
+  explicit limb_vector(size_t size, uint32_t value = 0) : limb_vector() {
+    resize(size, value);
+  }
+
+  // size zero limbs whose heap storage, if any, comes from resource.
+  limb_vector(size_t size, std::pmr::memory_resource* resource) : limb_vector() {
+    if (size > _capacity) {
+      reallocate(size, resource);
+    }
+    std::fill_n(data(), size, 0);
+    _size = size;
+  }
+
+  limb_vector(const_iterator first, const_iterator last) : limb_vector() {
+    assign(first, last);
+  }
+
+  limb_vector(const limb_vector& other) : limb_vector(other.begin(), other.end()) {}
+
+  limb_vector(limb_vector&& other) noexcept
+      : _size(other._size), _capacity(other._capacity), _resource(other._resource) {
+    if (other.isSmall()) {
+      std::copy_n(other._small, SMALL_SIZE, _small);
+    } else {
+      _heap = other._heap;
+      other._capacity = SMALL_SIZE;
+    }
+    other._size = 0;
+  }
+
+  limb_vector& operator=(const limb_vector& other) {
+    if (&other != this) {
+      assign(other.begin(), other.end());
+    }
+    return *this;
+  }
+
+  limb_vector& operator=(limb_vector&& other) noexcept {
+    if (&other != this) {
+      limb_vector(std::move(other)).swap(*this);
+    }
+    return *this;
+  }
+
+  ~limb_vector() {
+    if (!isSmall()) {
+      release(_heap, _capacity, _resource);
+    }
+  }
+
+  uint32_t* data() noexcept {
+    return isSmall() ? _small : _heap;
+  }
+
+  const uint32_t* data() const noexcept {
+    return isSmall() ? _small : _heap;
+  }
+
+  uint32_t& operator[](size_t index) noexcept {
+    return data()[index];
+  }
+
+  const uint32_t& operator[](size_t index) const noexcept {
+    return data()[index];
+  }
+
+  size_t size() const noexcept {
+    return _size;
+  }
+
+  size_t capacity() const noexcept {
+    return _capacity;
+  }
+
+  bool empty() const noexcept {
+    return _size == 0;
+  }
+
+  // The resource the next heap buffer comes from: the recorded one once on the heap, the thread's current one before.
+  std::pmr::memory_resource* resource() const noexcept;
+
+  iterator begin() noexcept {
+    return data();
+  }
+
+  const_iterator begin() const noexcept {
+    return data();
+  }
+
+  iterator end() noexcept {
+    return data() + _size;
+  }
+
+  const_iterator end() const noexcept {
+    return data() + _size;
+  }
+
+  reverse_iterator rbegin() noexcept {
+    return reverse_iterator(end());
+  }
+
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+
+  reverse_iterator rend() noexcept {
+    return reverse_iterator(begin());
+  }
+
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+
+  uint32_t& back() noexcept {
+    return data()[_size - 1];
+  }
+
+  const uint32_t& back() const noexcept {
+    return data()[_size - 1];
+  }
+
+  void push_back(uint32_t value) {
+    if (_size == _capacity) {
+      reallocate(2 * _capacity);
+    }
+    data()[_size++] = value;
+  }
+
+  void pop_back() noexcept {
+    --_size;
+  }
+
+  void clear() noexcept {
+    _size = 0;
+  }
+
+  void reserve(size_t capacity) {
+    if (capacity > _capacity) {
+      reallocate(capacity);
+    }
+  }
+
+  void resize(size_t size, uint32_t value = 0) {
+    if (size > _capacity) {
+      reallocate(std::max(size, 2 * _capacity));
+    }
+    if (size > _size) {
+      std::fill(end(), data() + size, value);
+    }
+    _size = size;
+  }
+
+  void assign(const_iterator first, const_iterator last) {
+    size_t count = last - first;
+    if (count > _capacity) {
+      limb_vector tmp;
+      tmp.reallocate(count, resource());
+      tmp.assign(first, last);
+      swap(tmp);
+      return;
+    }
+    std::copy(first, last, data());
+    _size = count;
+  }
+
+  iterator insert(const_iterator pos, size_t count, uint32_t value) {
+    iterator gap = makeGap(pos, count);
+    std::fill_n(gap, count, value);
+    return gap;
+  }
+
+  iterator insert(const_iterator pos, const_iterator first, const_iterator last) {
+    size_t index = pos - begin();
+    size_t count = last - first;
+    if (_size + count > _capacity) {
+      limb_vector tmp;
+      tmp.reallocate(std::max(_size + count, 2 * _capacity), resource());
+      tmp.assign(begin(), pos);
+      tmp.insert(tmp.end(), first, last);
+      tmp.insert(tmp.end(), pos, const_iterator(end()));
+      swap(tmp);
+      return begin() + index;
+    }
+    iterator gap = makeGap(pos, count);
+    std::copy(first, last, gap);
+    return gap;
+  }
+
+  iterator erase(const_iterator first, const_iterator last) noexcept {
+    iterator res = begin() + (first - begin());
+    std::copy(last, const_iterator(end()), res);
+    _size -= last - first;
+    return res;
+  }
+
+  void swap(limb_vector& other) noexcept {
+    if (isSmall() && other.isSmall()) {
+      std::swap(_small, other._small);
+    } else if (isSmall()) {
+      uint32_t* heap = other._heap;
+      std::copy_n(_small, SMALL_SIZE, other._small);
+      _heap = heap;
+    } else if (other.isSmall()) {
+      uint32_t* heap = _heap;
+      std::copy_n(other._small, SMALL_SIZE, _small);
+      other._heap = heap;
+    } else {
+      std::swap(_heap, other._heap);
+    }
+    std::swap(_size, other._size);
+    std::swap(_capacity, other._capacity);
+    std::swap(_resource, other._resource);
+  }
+
+  friend bool operator==(const limb_vector& a, const limb_vector& b) noexcept {
+    return a._size == b._size && std::equal(a.begin(), a.end(), b.begin());
+  }
+
+private:
+  bool isSmall() const noexcept {
+    return _capacity == SMALL_SIZE;
+  }
+
+  void reallocate(size_t capacity) {
+    reallocate(capacity, resource());
+  }
+
+  void reallocate(size_t capacity, std::pmr::memory_resource* resource);
+
+  static void release(uint32_t* heap, size_t capacity, std::pmr::memory_resource* resource) noexcept;
+
+  iterator makeGap(const_iterator pos, size_t count) {
+    size_t index = pos - begin();
+    if (_size + count > _capacity) {
+      reallocate(std::max(_size + count, 2 * _capacity));
+    }
+    std::copy_backward(begin() + index, end(), end() + count);
+    _size += count;
+    return begin() + index;
+  }
+
+  size_t _size;
+  size_t _capacity;
+  std::pmr::memory_resource* _resource;
+
+  union {
+    uint32_t _small[SMALL_SIZE] = {};
+    uint32_t* _heap;
+  };
+};
+
+// Memory resource that big integers on the calling thread take heap limbs from; nullptr, the default, means operator
+// new. Values that allocated from a resource must not outlive it, so a monotonic arena can back a whole computation
+// and be dropped at once.
+std::pmr::memory_resource* big_integer_resource() noexcept;
+
+// Installs resource for the calling thread and returns the previous one.
+std::pmr::memory_resource* set_big_integer_resource(std::pmr::memory_resource* resource) noexcept;
+
+// Installs a resource for the lifetime of the scope.
+class big_integer_resource_scope {
+public:
+  explicit big_integer_resource_scope(std::pmr::memory_resource* resource) noexcept
+      : _previous(set_big_integer_resource(resource)) {}
+
+  big_integer_resource_scope(const big_integer_resource_scope&) = delete;
+
+  big_integer_resource_scope& operator=(const big_integer_resource_scope&) = delete;
+
+  ~big_integer_resource_scope() {
+    set_big_integer_resource(_previous);
+  }
+
+private:
+  std::pmr::memory_resource* _previous;
+};
+
+struct big_integer;
+
+enum class division_rounding { truncate, floor };
+
+struct lazy_value;
+
+template <class L, class R, bool Subtract>
+struct lazy_sum;
+
+template <class L, class R>
+struct lazy_product;
+
+template <class E>
+struct lazy_negation;
+
+template <class E>
+concept big_integer_expression = E::is_lazy;
+
 struct big_integer {
   big_integer();
 
   big_integer(const big_integer& other);
 
+  big_integer(big_integer&& other) noexcept;
+
   big_integer(unsigned long long a);
 
   big_integer(long long a);
@@ -23,13 +342,20 @@ struct big_integer {
 
   big_integer(unsigned int a) : big_integer(static_cast<unsigned long long>(a)) {}
 
-  explicit big_integer(const std::string& str);
+  explicit big_integer(std::string_view str);
+
+  template <big_integer_expression E>
+  big_integer(const E& expr);
 
   ~big_integer();
 
 private:
   big_integer bigDivision(const big_integer& rhs);
 
+  void writeDecimal(char* out, size_t chunks);
+
+  static big_integer readDecimal(std::string_view digits);
+
   void trim();
 
   bool isZero() const;
@@ -38,30 +364,45 @@ private:
 
   void stretch(size_t size);
 
-  static uint32_t singleTwoAddition(uint32_t digit, uint32_t& carry);
-
   template <class BitWiseOperation>
-  void applyBitWiseOp(const big_integer& rhs, BitWiseOperation op) {
-    stretch(rhs._data.size());
-    uint32_t carry = 1, rhs_carry = 1;
-    for (size_t i = 0; i < _data.size(); i++) {
-      uint32_t res = _sign ? singleTwoAddition(_data[i], carry) : _data[i];
-      uint32_t rhs_res =
-          i < rhs._data.size() ? rhs._sign ? singleTwoAddition(rhs._data[i], rhs_carry) : rhs._data[i] : 0;
-      _data[i] = op(res, rhs_res);
-    }
-    _sign = op(_sign, rhs._sign);
-    carry = 1;
-    if (_sign) {
-      for (size_t i = 0; i < _data.size(); i++) {
-        _data[i] = singleTwoAddition(_data[i], carry);
-      }
-    }
-    trim();
-  }
+  void applyBitWiseOp(const big_integer& rhs, BitWiseOperation op);
 
   uint32_t singleWordDiv(uint32_t b);
 
+  void shiftLeft(size_t bits);
+
+  void shiftRight(size_t bits);
+
+  static big_integer powModPowerOfTwo(const big_integer& base, const big_integer& exp, size_t bits);
+
+  static big_integer gcdCore(big_integer a, big_integer b, big_integer* cofactor);
+
+  static big_integer rootCore(const big_integer& n, uint32_t k, big_integer* power);
+
+  static bool probablePrimeCore(const big_integer& n, unsigned rounds);
+
+  struct lazy_term {
+    const big_integer* value;
+    bool negative;
+    const uint32_t* limbs = nullptr;
+    size_t size = 0;
+    int64_t mask = 0;
+  };
+
+  static void collectTerms(const lazy_value& expr, bool negative, lazy_term*& terms, big_integer*& products);
+
+  template <class L, class R, bool Subtract>
+  static void collectTerms(const lazy_sum<L, R, Subtract>& expr, bool negative, lazy_term*& terms,
+                           big_integer*& products);
+
+  template <class L, class R>
+  static void collectTerms(const lazy_product<L, R>& expr, bool negative, lazy_term*& terms, big_integer*& products);
+
+  template <class E>
+  static void collectTerms(const lazy_negation<E>& expr, bool negative, lazy_term*& terms, big_integer*& products);
+
+  void assignSum(lazy_term* terms, size_t count);
+
   void sumAbs(const big_integer& b);
 
   void sumDigitAbs(uint32_t b);
@@ -72,7 +413,9 @@ private:
 
   void mulAbs(const big_integer& b);
 
-  void mulDigitAbs(uint32_t b);
+  void addProduct(const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size, bool negative);
+
+  void sqrAbs();
 
   bool compareLessAbs(const big_integer& other) const;
 
@@ -81,6 +424,11 @@ public:
 
   big_integer& operator=(const big_integer& other);
 
+  big_integer& operator=(big_integer&& other) noexcept;
+
+  template <big_integer_expression E>
+  big_integer& operator=(const E& expr);
+
   big_integer& operator+=(const big_integer& rhs);
 
   big_integer& operator-=(const big_integer& rhs);
@@ -103,9 +451,13 @@ public:
 
   big_integer operator+() const;
 
-  big_integer operator-() const;
+  big_integer operator-() const&;
+
+  big_integer operator-() &&;
 
-  big_integer operator~() const;
+  big_integer operator~() const&;
+
+  big_integer operator~() &&;
 
   big_integer& operator++();
 
@@ -127,34 +479,183 @@ public:
 
   friend bool operator>=(const big_integer& a, const big_integer& b);
 
+  friend big_integer sqr(const big_integer& a);
+
+  friend void divmod(const big_integer& a, const big_integer& b, big_integer& quotient, big_integer& remainder,
+                     division_rounding rounding);
+
+  friend void addmul(big_integer& acc, const big_integer& a, const big_integer& b);
+
+  friend void addmul(big_integer& acc, const big_integer& a, uint32_t b);
+
+  friend void submul(big_integer& acc, const big_integer& a, const big_integer& b);
+
+  friend void submul(big_integer& acc, const big_integer& a, uint32_t b);
+
+  friend void shift_left(big_integer& a, size_t bits);
+
+  friend void shift_right(big_integer& a, size_t bits);
+
+  friend big_integer pow(const big_integer& base, uint64_t exp);
+
+  friend big_integer pow_mod(const big_integer& base, const big_integer& exp, const big_integer& mod);
+
+  friend big_integer gcd(const big_integer& a, const big_integer& b);
+
+  friend big_integer lcm(const big_integer& a, const big_integer& b);
+
+  friend big_integer extended_gcd(const big_integer& a, const big_integer& b, big_integer& x, big_integer& y);
+
+  friend big_integer mod_inverse(const big_integer& a, const big_integer& mod);
+
+  friend big_integer isqrt(const big_integer& n);
+
+  friend std::pair<big_integer, big_integer> isqrt_rem(const big_integer& n);
+
+  friend big_integer iroot(const big_integer& n, uint32_t k);
+
+  friend bool is_probable_prime(const big_integer& n, unsigned rounds);
+
+  friend big_integer next_prime(const big_integer& n);
+
   friend std::string to_string(const big_integer& a);
 
+  friend struct big_reciprocal;
+
+  friend struct modulus_context;
+
 private:
-  std::vector<uint32_t> _data;
+  limb_vector _data;
   bool _sign;
   static const uint64_t base = 4294967296;
 };
 
 big_integer operator+(const big_integer& a, const big_integer& b);
 
+big_integer operator+(big_integer&& a, const big_integer& b);
+
+big_integer operator+(const big_integer& a, big_integer&& b);
+
+big_integer operator+(big_integer&& a, big_integer&& b);
+
 big_integer operator-(const big_integer& a, const big_integer& b);
 
+big_integer operator-(big_integer&& a, const big_integer& b);
+
 big_integer operator*(const big_integer& a, const big_integer& b);
 
+big_integer operator*(big_integer&& a, const big_integer& b);
+
+big_integer operator*(const big_integer& a, big_integer&& b);
+
+big_integer operator*(big_integer&& a, big_integer&& b);
+
 big_integer operator/(const big_integer& a, const big_integer& b);
 
+big_integer operator/(big_integer&& a, const big_integer& b);
+
 big_integer operator%(const big_integer& a, const big_integer& b);
 
+big_integer operator%(big_integer&& a, const big_integer& b);
+
+big_integer sqr(const big_integer& a);
+
+// Quotient and remainder from a single division. truncate rounds the quotient toward zero, as operator/ does, and
+// floor rounds it down, so that the remainder takes the sign of b.
+std::pair<big_integer, big_integer> divmod(const big_integer& a, const big_integer& b,
+                                           division_rounding rounding = division_rounding::truncate);
+
+void divmod(const big_integer& a, const big_integer& b, big_integer& quotient, big_integer& remainder,
+            division_rounding rounding = division_rounding::truncate);
+
+// acc += a * b and acc -= a * b without a temporary for the product.
+void addmul(big_integer& acc, const big_integer& a, const big_integer& b);
+
+void addmul(big_integer& acc, const big_integer& a, uint32_t b);
+
+void submul(big_integer& acc, const big_integer& a, const big_integer& b);
+
+void submul(big_integer& acc, const big_integer& a, uint32_t b);
+
+// a <<= bits and a >>= bits with counts beyond the range of int.
+void shift_left(big_integer& a, size_t bits);
+
+void shift_right(big_integer& a, size_t bits);
+
+// base^exp; pow(0, 0) == 1. Throws std::length_error when the result could not be addressed.
+big_integer pow(const big_integer& base, uint64_t exp);
+
+// base^exp mod |mod| in [0, |mod|) for exp >= 0. Odd moduli use Montgomery multiplication with a sliding window over
+// the exponent; an even modulus is split into its odd part and a power of two.
+big_integer pow_mod(const big_integer& base, const big_integer& exp, const big_integer& mod);
+
+// Greatest common divisor and least common multiple, both non-negative; gcd(0, 0) == 0.
+big_integer gcd(const big_integer& a, const big_integer& b);
+
+big_integer lcm(const big_integer& a, const big_integer& b);
+
+// Returns g = gcd(a, b) and sets x and y with a * x + b * y == g.
+big_integer extended_gcd(const big_integer& a, const big_integer& b, big_integer& x, big_integer& y);
+
+// x in [0, |mod|) with a * x == 1 (mod mod); throws std::invalid_argument when gcd(a, mod) != 1.
+big_integer mod_inverse(const big_integer& a, const big_integer& mod);
+
+// floor(sqrt(n)) for n >= 0, and the pair {floor(sqrt(n)), n - floor(sqrt(n))^2}; both throw std::invalid_argument for
+// negative n.
+big_integer isqrt(const big_integer& n);
+
+std::pair<big_integer, big_integer> isqrt_rem(const big_integer& n);
+
+// The k-th root of n rounded toward zero, for k >= 1; negative n requires an odd k.
+big_integer iroot(const big_integer& n, uint32_t k);
+
+// n!, the binomial coefficient C(n, k) (0 for k > n) and the product of all primes up to n. The factorial and binomial
+// coefficients near the middle are assembled from their prime factorisations.
+big_integer factorial(uint64_t n);
+
+big_integer binomial(uint64_t n, uint64_t k);
+
+big_integer primorial(uint64_t n);
+
+// Baillie-PSW probable-prime test after trial division by the primes up to 1619, plus rounds of Miller-Rabin with
+// pseudo-random bases. No composite is known to pass the test with zero rounds. Negative numbers are not prime.
+bool is_probable_prime(const big_integer& n, unsigned rounds = 0);
+
+// The least probable prime greater than n.
+big_integer next_prime(const big_integer& n);
+
 big_integer operator&(const big_integer& a, const big_integer& b);
 
+big_integer operator&(big_integer&& a, const big_integer& b);
+
+big_integer operator&(const big_integer& a, big_integer&& b);
+
+big_integer operator&(big_integer&& a, big_integer&& b);
+
 big_integer operator|(const big_integer& a, const big_integer& b);
 
+big_integer operator|(big_integer&& a, const big_integer& b);
+
+big_integer operator|(const big_integer& a, big_integer&& b);
+
+big_integer operator|(big_integer&& a, big_integer&& b);
+
 big_integer operator^(const big_integer& a, const big_integer& b);
 
+big_integer operator^(big_integer&& a, const big_integer& b);
+
+big_integer operator^(const big_integer& a, big_integer&& b);
+
+big_integer operator^(big_integer&& a, big_integer&& b);
+
 big_integer operator<<(const big_integer& a, int b);
 
+big_integer operator<<(big_integer&& a, int b);
+
 big_integer operator>>(const big_integer& a, int b);
 
+big_integer operator>>(big_integer&& a, int b);
+
 bool operator==(const big_integer& a, const big_integer& b);
 
 bool operator!=(const big_integer& a, const big_integer& b);
@@ -170,3 +671,247 @@ bool operator>=(const big_integer& a, const big_integer& b);
 std::string to_string(const big_integer& a);
 
 std::ostream& operator<<(std::ostream& out, const big_integer& a);
+
+struct big_reciprocal {
+  explicit big_reciprocal(const big_integer& divisor);
+
+  const big_integer& divisor() const;
+
+  big_integer divide(const big_integer& a) const;
+
+  big_integer remainder(const big_integer& a) const;
+
+private:
+  big_integer divideAbs(big_integer& a) const;
+
+  big_integer _divisor;
+  big_integer _normalized;
+  big_integer _inverse;
+  int _shift;
+
+  friend struct big_integer;
+};
+
+// Arithmetic modulo a fixed nonzero modulus with the Barrett reciprocal and, for odd moduli, the Montgomery constants
+// computed once. Results lie in [0, |modulus|) for operands of any sign and size; only the constructor divides. The
+// overloads taking res reuse its storage, and temporaries come from per-thread scratch space.
+struct modulus_context {
+  explicit modulus_context(const big_integer& modulus);
+
+  const big_integer& modulus() const;
+
+  big_integer reduce(const big_integer& a) const;
+
+  void reduce(const big_integer& a, big_integer& res) const;
+
+  big_integer add_mod(const big_integer& a, const big_integer& b) const;
+
+  void add_mod(const big_integer& a, const big_integer& b, big_integer& res) const;
+
+  big_integer mul_mod(const big_integer& a, const big_integer& b) const;
+
+  void mul_mod(const big_integer& a, const big_integer& b, big_integer& res) const;
+
+  big_integer sqr_mod(const big_integer& a) const;
+
+  void sqr_mod(const big_integer& a, big_integer& res) const;
+
+  big_integer pow_mod(const big_integer& base, const big_integer& exp) const;
+
+private:
+  friend struct big_integer;
+
+  bool strongLucasTest() const;
+
+  void barrettStep(uint32_t* res, const uint32_t* x) const;
+
+  void reduceLimbs(uint32_t* res, const uint32_t* x, size_t size, bool negative) const;
+
+  void residue(uint32_t* res, const big_integer& a) const;
+
+  void store(big_integer& res, const uint32_t* r) const;
+
+  big_integer _modulus;
+  big_integer _reciprocal;
+  big_integer _r_squared;
+  uint64_t _montgomery_inverse;
+};
+
+// Opt-in lazy arithmetic. lazy(a) * b + lazy(c) * d - e builds an expression that is evaluated when it is assigned to
+// a big_integer: every product is computed once and all the signed terms are added in one pass over the limbs, reusing
+// the storage of the destination. An expression keeps references to its operands, so it has to be assigned within the
+// full-expression that creates it. The overloads taking big_integer&& let converted temporaries such as integer
+// literals take part without ambiguity against the eager operators.
+struct lazy_value {
+  static constexpr bool is_lazy = true;
+  static constexpr size_t terms = 1;
+  static constexpr size_t products = 0;
+
+  const big_integer& value;
+};
+
+template <class L, class R, bool Subtract>
+struct lazy_sum {
+  static constexpr bool is_lazy = true;
+  static constexpr size_t terms = L::terms + R::terms;
+  static constexpr size_t products = L::products + R::products;
+
+  L lhs;
+  R rhs;
+};
+
+template <class L, class R>
+struct lazy_product {
+  static constexpr bool is_lazy = true;
+  static constexpr size_t terms = 1;
+  static constexpr size_t products = 1;
+
+  L lhs;
+  R rhs;
+};
+
+template <class E>
+struct lazy_negation {
+  static constexpr bool is_lazy = true;
+  static constexpr size_t terms = E::terms;
+  static constexpr size_t products = E::products;
+
+  E arg;
+};
+
+inline lazy_value lazy(const big_integer& a) {
+  return {a};
+}
+
+inline const big_integer& lazyOperand(const lazy_value& a) {
+  return a.value;
+}
+
+template <big_integer_expression E>
+big_integer lazyOperand(const E& a) {
+  return a;
+}
+
+template <big_integer_expression L, big_integer_expression R>
+lazy_sum<L, R, false> operator+(const L& a, const R& b) {
+  return {a, b};
+}
+
+template <big_integer_expression L>
+lazy_sum<L, lazy_value, false> operator+(const L& a, const big_integer& b) {
+  return {a, lazy(b)};
+}
+
+template <big_integer_expression L>
+lazy_sum<L, lazy_value, false> operator+(const L& a, big_integer&& b) {
+  return {a, lazy(b)};
+}
+
+template <big_integer_expression R>
+lazy_sum<lazy_value, R, false> operator+(const big_integer& a, const R& b) {
+  return {lazy(a), b};
+}
+
+template <big_integer_expression R>
+lazy_sum<lazy_value, R, false> operator+(big_integer&& a, const R& b) {
+  return {lazy(a), b};
+}
+
+template <big_integer_expression L, big_integer_expression R>
+lazy_sum<L, R, true> operator-(const L& a, const R& b) {
+  return {a, b};
+}
+
+template <big_integer_expression L>
+lazy_sum<L, lazy_value, true> operator-(const L& a, const big_integer& b) {
+  return {a, lazy(b)};
+}
+
+template <big_integer_expression L>
+lazy_sum<L, lazy_value, true> operator-(const L& a, big_integer&& b) {
+  return {a, lazy(b)};
+}
+
+template <big_integer_expression R>
+lazy_sum<lazy_value, R, true> operator-(const big_integer& a, const R& b) {
+  return {lazy(a), b};
+}
+
+template <big_integer_expression R>
+lazy_sum<lazy_value, R, true> operator-(big_integer&& a, const R& b) {
+  return {lazy(a), b};
+}
+
+template <big_integer_expression L, big_integer_expression R>
+lazy_product<L, R> operator*(const L& a, const R& b) {
+  return {a, b};
+}
+
+template <big_integer_expression L>
+lazy_product<L, lazy_value> operator*(const L& a, const big_integer& b) {
+  return {a, lazy(b)};
+}
+
+template <big_integer_expression L>
+lazy_product<L, lazy_value> operator*(const L& a, big_integer&& b) {
+  return {a, lazy(b)};
+}
+
+template <big_integer_expression R>
+lazy_product<lazy_value, R> operator*(const big_integer& a, const R& b) {
+  return {lazy(a), b};
+}
+
+template <big_integer_expression R>
+lazy_product<lazy_value, R> operator*(big_integer&& a, const R& b) {
+  return {lazy(a), b};
+}
+
+template <big_integer_expression E>
+lazy_negation<E> operator-(const E& a) {
+  return {a};
+}
+
+template <big_integer_expression E>
+big_integer::big_integer(const E& expr) : big_integer() {
+  *this = expr;
+}
+
+template <big_integer_expression E>
+big_integer& big_integer::operator=(const E& expr) {
+  std::array<big_integer, E::products> products;
+  std::array<lazy_term, E::terms> terms;
+  lazy_term* terms_end = terms.data();
+  big_integer* products_end = products.data();
+  collectTerms(expr, false, terms_end, products_end);
+  if constexpr (E::terms == 1 && E::products == 1) {
+    *this = terms[0].negative ? -std::move(products[0]) : std::move(products[0]);
+  } else {
+    assignSum(terms.data(), terms.size());
+  }
+  return *this;
+}
+
+inline void big_integer::collectTerms(const lazy_value& expr, bool negative, lazy_term*& terms, big_integer*&) {
+  *terms++ = {&expr.value, negative};
+}
+
+template <class L, class R, bool Subtract>
+void big_integer::collectTerms(const lazy_sum<L, R, Subtract>& expr, bool negative, lazy_term*& terms,
+                               big_integer*& products) {
+  collectTerms(expr.lhs, negative, terms, products);
+  collectTerms(expr.rhs, negative != Subtract, terms, products);
+}
+
+template <class L, class R>
+void big_integer::collectTerms(const lazy_product<L, R>& expr, bool negative, lazy_term*& terms,
+                               big_integer*& products) {
+  *products = lazyOperand(expr.lhs) * lazyOperand(expr.rhs);
+  *terms++ = {products++, negative};
+}
+
+template <class E>
+void big_integer::collectTerms(const lazy_negation<E>& expr, bool negative, lazy_term*& terms,
+                               big_integer*& products) {
+  collectTerms(expr.arg, !negative, terms, products);
+}
@@ -2,11 +2,18 @@
 #include "gtest/gtest.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cstdlib>
 #include <limits>
+#include <memory>
+#include <memory_resource>
+#include <new>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
 
 namespace {
 
@@ -82,6 +89,150 @@ TEST(correctness, copy_ctor_real_copy2) {
   EXPECT_EQ(3, a);
 }
 
+TEST(correctness, small_and_large_storage) {
+  big_integer small = -123;
+  big_integer large = big_integer(1) << 1000;
+  big_integer a = small;
+
+  a += large;
+  EXPECT_EQ(large - 123, a);
+  a -= large;
+  EXPECT_EQ(small, a);
+
+  big_integer b = large;
+  std::swap(a, b);
+  EXPECT_EQ(large, a);
+  EXPECT_EQ(small, b);
+
+  b = a;
+  a = small;
+  EXPECT_EQ(large, b);
+  EXPECT_EQ(small, a);
+
+  big_integer counter = std::numeric_limits<uint64_t>::max();
+  for (int i = 0; i < 64; i++) {
+    counter <<= 1;
+    ++counter;
+  }
+  EXPECT_EQ((big_integer(1) << 128) - 1, counter);
+  counter >>= 100;
+  EXPECT_EQ((big_integer(1) << 28) - 1, counter);
+}
+
+namespace {
+
+class counting_resource : public std::pmr::memory_resource {
+public:
+  size_t allocated = 0;
+  size_t deallocated = 0;
+
+private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    allocated += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+    deallocated += bytes;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+std::atomic<size_t> global_allocations = 0;
+
+} // namespace
+
+void* operator new(size_t size) {
+  global_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+TEST(correctness, memory_resource) {
+  counting_resource resource;
+  big_integer outside = big_integer(1) << 500;
+  {
+    big_integer_resource_scope scope(&resource);
+    EXPECT_EQ(&resource, big_integer_resource());
+
+    big_integer small = 12345;
+    small *= 6789;
+    EXPECT_EQ(0, resource.allocated);
+
+    big_integer a = (big_integer(1) << 1000) - 1;
+    big_integer b = a * a + outside;
+    EXPECT_EQ((big_integer(1) << 2000) - (big_integer(1) << 1001) + 1 + outside, b);
+    EXPECT_LT(0, resource.allocated);
+  }
+  EXPECT_EQ(nullptr, big_integer_resource());
+  EXPECT_EQ(resource.allocated, resource.deallocated);
+  EXPECT_EQ(big_integer(1) << 500, outside);
+
+  // Values already on the heap keep their resource when they grow or are assigned to inside a scope.
+  big_integer grown = outside;
+  big_integer squared = outside + 1;
+  big_integer divided = outside - 1;
+  big_integer assigned = outside;
+  big_integer reduced = outside;
+  {
+    auto arena = std::make_unique<counting_resource>();
+    {
+      big_integer_resource_scope scope(arena.get());
+      big_integer result = (big_integer(1) << 3000) + 1;
+      grown <<= 2000;
+      grown += result;
+      grown *= result;
+      squared *= squared;
+      divided *= result;
+      divided %= outside;
+      divided <<= 5000;
+      divided /= 3;
+      assigned = result;
+      reduced %= result;
+      reduced *= result;
+    }
+    EXPECT_LT(0, arena->allocated);
+    EXPECT_EQ(arena->allocated, arena->deallocated);
+  }
+  big_integer result = (big_integer(1) << 3000) + 1;
+  EXPECT_EQ(((outside << 2000) + result) * result, grown);
+  EXPECT_EQ((outside + 1) * (outside + 1), squared);
+  EXPECT_EQ(((outside - 1) * result % outside << 5000) / 3, divided);
+  EXPECT_EQ(result, assigned);
+  EXPECT_EQ(outside * result, reduced);
+
+  // The per-thread cache of decimal powers must not keep memory of a resource that is gone, so this runs on a fresh
+  // thread whose cache is first filled inside the scope.
+  std::thread([] {
+    big_integer a = (big_integer(1) << 20000) - 1;
+    std::string expected;
+    {
+      auto arena = std::make_unique<counting_resource>();
+      {
+        big_integer_resource_scope scope(arena.get());
+        expected = to_string(a);
+        EXPECT_EQ(a, big_integer(expected));
+      }
+      EXPECT_EQ(arena->allocated, arena->deallocated);
+    }
+    EXPECT_EQ(expected, to_string(a));
+  }).join();
+}
+
 TEST(correctness, ctor_invalid_string) {
   EXPECT_THROW(big_integer("abc"), std::invalid_argument);
   EXPECT_THROW(big_integer("123x"), std::invalid_argument);
@@ -117,6 +268,53 @@ TEST(correctness, assignment_return_value) {
   EXPECT_TRUE(b == 7);
 }
 
+TEST(correctness, move_semantics) {
+  static_assert(std::is_nothrow_move_constructible_v<big_integer>);
+  static_assert(std::is_nothrow_move_assignable_v<big_integer>);
+
+  big_integer large = (big_integer(1) << 1000) - 1;
+  big_integer a = large;
+  big_integer b = std::move(a);
+  EXPECT_EQ(large, b);
+
+  a = 5;
+  EXPECT_EQ(5, a);
+  a = std::move(b);
+  EXPECT_EQ(large, a);
+
+  big_integer c = 7;
+  EXPECT_EQ(large + 12, a + c + 5);
+  EXPECT_EQ(large * 7 - 5, (a * 7) - big_integer(5));
+  EXPECT_EQ(-large, -(a + 0));
+  EXPECT_EQ(-large - 1, ~(a + 0));
+  EXPECT_EQ(0, ~big_integer(-1));
+  EXPECT_EQ(c & large, big_integer(7) & (a + 0));
+  EXPECT_EQ((large >> 990) % 1000, ((a << 10) >> 1000) % big_integer(1000));
+}
+
+TEST(correctness, lazy_expressions) {
+  big_integer a = (big_integer(1) << 300) + 17;
+  big_integer b = -(big_integer(3) << 200);
+  big_integer c = 123456789;
+  big_integer d = (big_integer(1) << 400) - 1;
+  big_integer e = -5;
+
+  big_integer r = lazy(a) * b + lazy(c) * d - e;
+  EXPECT_EQ(a * b + c * d - e, r);
+  r = -(lazy(a) - b) + c - lazy(d) * d;
+  EXPECT_EQ(-(a - b) + c - d * d, r);
+  r = -(lazy(b) * c);
+  EXPECT_EQ(-(b * c), r);
+  r = lazy(d) - d;
+  EXPECT_EQ(0, r);
+  r = lazy(e) + 5 - 1;
+  EXPECT_EQ(-1, r);
+
+  big_integer expected = a * a - a;
+  a = lazy(a) * a - a;
+  EXPECT_EQ(expected, a);
+}
+
 TEST(correctness, comparisons) {
   big_integer a = 100;
   big_integer b = 100;
@@ -244,6 +442,23 @@ TEST(correctness, mul) {
   EXPECT_TRUE(a == 100);
 }
 
+TEST(correctness, mul_allocations) {
+  for (size_t size : {250, 1000}) {
+    big_integer a = (big_integer(1) << (32 * size)) / 3;
+    big_integer b = (big_integer(1) << (32 * size)) / 7;
+    big_integer product = a * b;
+    big_integer square = a * a;
+
+    // Temporaries of the Toom kernels come from the scratch stack, which is warm by now: only the copy of the left
+    // operand and the two results allocate.
+    size_t before = global_allocations;
+    product = a * b;
+    square = a * a;
+    EXPECT_GE(3, global_allocations - before) << size;
+    EXPECT_EQ(a * a, square);
+  }
+}
+
 TEST(correctness, mul_signed) {
   big_integer a = -5;
   big_integer b = 20;
@@ -262,6 +477,34 @@ TEST(correctness, mul_return_value) {
   EXPECT_EQ(20, a);
 }
 
+TEST(correctness, addmul_submul) {
+  big_integer a = (big_integer(1) << 200) + 3;
+  big_integer b = -(big_integer(1) << 150) + 7;
+  big_integer acc = 100;
+
+  addmul(acc, a, b);
+  EXPECT_EQ(100 + a * b, acc);
+  submul(acc, a, b);
+  EXPECT_EQ(100, acc);
+  submul(acc, a, 10);
+  EXPECT_EQ(100 - a * 10, acc);
+  addmul(acc, a, 10);
+  EXPECT_EQ(100, acc);
+  submul(acc, big_integer(10), 10);
+  EXPECT_EQ(0, acc);
+
+  big_integer large = (big_integer(1) << 5000) - 1;
+  acc = large * large;
+  submul(acc, large, large);
+  EXPECT_EQ(0, acc);
+  addmul(acc, large, -large);
+  EXPECT_EQ(-(large * large), acc);
+
+  acc = a;
+  addmul(acc, acc, acc);
+  EXPECT_EQ(a + a * a, acc);
+}
+
 TEST(correctness, div_) {
   big_integer a = 20;
   big_integer b = 5;
@@ -277,6 +520,213 @@ TEST(correctness, div_) {
   EXPECT_TRUE(c == 0);
 }
 
+TEST(correctness, pow_mod) {
+  big_integer p = (big_integer(1) << 521) - 1;
+  EXPECT_EQ(1, pow_mod(3, p - 1, p));
+
+  big_integer m = (big_integer(1) << 255) - 19;
+  big_integer e = (big_integer(1) << 200) + 12345;
+  EXPECT_EQ(big_integer("46802966308366788883395792226784302866475278959565770833983060695292919647793"),
+            pow_mod(big_integer("123456789123456789123456789"), e, m));
+
+  big_integer even = ((big_integer(1) << 127) - 1) << 70;
+  EXPECT_EQ(big_integer("18141004201479799189052635042398029153255120865589200502831"),
+            pow_mod(big_integer("-987654321987654321"), big_integer("1000000000000000000000000000007"), even));
+  EXPECT_EQ(pow_mod(12345, e, even), pow_mod(12345, e, -even));
+  EXPECT_EQ((big_integer(1) << 100) - 125, pow_mod(-5, 3, big_integer(1) << 100));
+
+  EXPECT_EQ(1, pow_mod(0, 0, 7));
+  EXPECT_EQ(0, pow_mod(5, 0, 1));
+  EXPECT_EQ(0, pow_mod(m, 3, m));
+  EXPECT_THROW(pow_mod(2, 3, 0), std::runtime_error);
+  EXPECT_THROW(pow_mod(2, -3, 7), std::invalid_argument);
+}
+
+TEST(correctness, modulus_context) {
+  big_integer a = -pow_mod(3, 200, big_integer(1) << 400);
+  big_integer b = pow_mod(7, 150, big_integer(1) << 500);
+
+  modulus_context odd((big_integer(1) << 255) - 19);
+  EXPECT_EQ(big_integer("27996440730124883696487727990342894176463465067861376809077722529036595155909"),
+            odd.reduce(a));
+  EXPECT_EQ(big_integer("32871608979841764025053108205184818365899757102839688525216002501230641640865"),
+            odd.add_mod(a, b));
+  EXPECT_EQ(big_integer("55686983578251583836333346803494135562688625979785792060646808187493026176660"),
+            odd.mul_mod(a, b));
+  EXPECT_EQ(big_integer("51107592586466556143294531641080275909603851086181276367712826055948806573829"),
+            odd.sqr_mod(b));
+  EXPECT_EQ(big_integer("4219634094361444306125312281871929569565940941097358048551250493472693590523"),
+            odd.pow_mod(b, 65537));
+
+  modulus_context even(-(big_integer(1) << 200) - (big_integer(1) << 64));
+  EXPECT_EQ(big_integer("1305702673659869046101456595950080100145651359672865057623903"), even.reduce(a));
+  EXPECT_EQ(big_integer("887397686538263778009108692572451804719242057782166498842703"), even.mul_mod(a, b));
+  EXPECT_EQ(big_integer("1371149287054392363464415697387866608816462340966685539067025"), even.pow_mod(b, 12345));
+
+  big_integer x = b;
+  odd.mul_mod(x, x, x);
+  EXPECT_EQ(odd.sqr_mod(b), x);
+  odd.add_mod(x, odd.modulus() - x, x);
+  EXPECT_EQ(0, x);
+  EXPECT_EQ(0, modulus_context(1).mul_mod(a, b));
+  EXPECT_THROW(modulus_context(0), std::runtime_error);
+}
+
+TEST(correctness, pow_) {
+  EXPECT_EQ(big_integer("515377520732011331036461129765621272702107522001"), pow(3, 100));
+  EXPECT_EQ(big_integer("-176372588156290374069930666601805113523699712"), pow(-12, 41));
+  EXPECT_EQ(big_integer("308039095855459744563698878906368"), pow(big_integer(3) << 20, 5));
+  EXPECT_EQ(big_integer(1) << 1000, pow(-2, 1000));
+  EXPECT_EQ(sqr(sqr(pow(big_integer("123456789012345678901234567890"), 5))),
+            pow(big_integer("123456789012345678901234567890"), 20));
+
+  EXPECT_EQ(1, pow(0, 0));
+  EXPECT_EQ(0, pow(0, 7));
+  EXPECT_EQ(-1, pow(-1, (uint64_t(1) << 63) + 1));
+  EXPECT_THROW(pow(3, std::numeric_limits<uint64_t>::max()), std::length_error);
+}
+
+TEST(correctness, factorial_) {
+  EXPECT_EQ(big_integer("30414093201713378043612608166064768844377641568960512000000000000"), factorial(50));
+  EXPECT_EQ(factorial(1000), factorial(999) * 1000);
+  EXPECT_EQ(1, factorial(0));
+  EXPECT_EQ(1, factorial(1));
+
+  EXPECT_EQ(big_integer("100891344545564193334812497256"), binomial(100, 50));
+  EXPECT_EQ(big_integer("166666666666166666666667000000000000"), binomial(1000000000000, 3));
+  EXPECT_EQ(binomial(2000, 700), factorial(2000) / factorial(700) / factorial(1300));
+  EXPECT_EQ(binomial(300, 10), binomial(300, 290));
+  EXPECT_EQ(1, binomial(5, 0));
+  EXPECT_EQ(0, binomial(5, 6));
+
+  EXPECT_EQ(big_integer("2305567963945518424753102147331756070"), primorial(100));
+  EXPECT_EQ(primorial(100) * 101, primorial(102));
+  EXPECT_EQ(1, primorial(1));
+}
+
+TEST(correctness, is_probable_prime_) {
+  EXPECT_TRUE(is_probable_prime(2));
+  EXPECT_TRUE(is_probable_prime(1619));
+  EXPECT_TRUE(is_probable_prime(2147483647));
+  EXPECT_TRUE(is_probable_prime((big_integer(1) << 521) - 1, 5));
+  EXPECT_TRUE(is_probable_prime(big_integer("170141183460469231731687303715884105727")));
+
+  EXPECT_FALSE(is_probable_prime(0));
+  EXPECT_FALSE(is_probable_prime(1));
+  EXPECT_FALSE(is_probable_prime(-7));
+  EXPECT_FALSE(is_probable_prime(1621 * 1621));
+  EXPECT_FALSE(is_probable_prime((big_integer(1) << 523) - 1));
+  // Strong pseudoprimes to base 2, Lucas pseudoprimes and a Carmichael number.
+  EXPECT_FALSE(is_probable_prime(3215031751));
+  EXPECT_FALSE(is_probable_prime(big_integer("3825123056546413051")));
+  EXPECT_FALSE(is_probable_prime(big_integer("318665857834031151167461")));
+  EXPECT_FALSE(is_probable_prime(5459));
+  EXPECT_FALSE(is_probable_prime(10877));
+  EXPECT_FALSE(is_probable_prime(9999109081));
+  EXPECT_FALSE(is_probable_prime(sqr(big_integer("170141183460469231731687303715884105727"))));
+}
+
+TEST(correctness, next_prime_) {
+  EXPECT_EQ(2, next_prime(-10));
+  EXPECT_EQ(3, next_prime(2));
+  EXPECT_EQ(1621, next_prime(1619));
+  EXPECT_EQ(pow(10, 100) + 267, next_prime(pow(10, 100)));
+  EXPECT_EQ(pow(10, 300) + 331, next_prime(pow(10, 300) + 1));
+}
+
+TEST(correctness, gcd_) {
+  big_integer a("-7425690188304803929920433312299809397093115663527031633152458877440259146961821084796994977792");
+  big_integer b("1434132762573091174458650431944306546938605606555938720703125000000000000000000000000000000000");
+  big_integer g("1775370368440183430884846731264");
+
+  EXPECT_EQ(g, gcd(a, b));
+  EXPECT_EQ(g, gcd(b, a));
+  EXPECT_EQ(big_integer("59984247642489991566847928063190869819355418268444924877721165562913133935928344"
+                        "72656250000000000000000000000000000000000000000000000000000000000000000000000"),
+            lcm(a, b));
+
+  big_integer x;
+  big_integer y;
+  EXPECT_EQ(g, extended_gcd(a, b, x, y));
+  EXPECT_EQ(g, a * x + b * y);
+  EXPECT_EQ(big_integer(12), extended_gcd(0, -12, x, y));
+  EXPECT_EQ(-1, y);
+
+  EXPECT_EQ(0, gcd(0, 0));
+  EXPECT_EQ(0, lcm(a, 0));
+  EXPECT_EQ(big_integer(5), gcd(-5, 0));
+
+  big_integer m = (big_integer(1) << 127) - 1;
+  EXPECT_EQ(big_integer("93188824061090461428114044949975930147"), mod_inverse(pow_mod(3, 80, m), m));
+  EXPECT_EQ(1, mod_inverse(-1, 2));
+  EXPECT_THROW(mod_inverse(a, b), std::invalid_argument);
+}
+
+TEST(correctness, isqrt_) {
+  big_integer n = (big_integer(1) << 521) - 1;
+  auto [root, rem] = isqrt_rem(n);
+  EXPECT_EQ(big_integer("2620075888238852083761638449375348105840237839079783585978299315224216153039529"), root);
+  EXPECT_EQ(big_integer("1956131728183669159926538792870008400963784485204425500983283458538665678515310"), rem);
+  EXPECT_EQ(root, isqrt(n));
+  EXPECT_EQ(root + 1, isqrt(n - rem + 2 * root + 1));
+  EXPECT_EQ(root, isqrt(n - rem + 2 * root));
+
+  EXPECT_EQ(0, isqrt(0));
+  EXPECT_EQ(1, isqrt(3));
+  EXPECT_THROW(isqrt(-1), std::invalid_argument);
+}
+
+TEST(correctness, iroot_) {
+  big_integer n("1000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000");
+  EXPECT_EQ(big_integer("1000000000000000000000000000000"), iroot(n, 3));
+  EXPECT_EQ(big_integer("999999999999999999999999999999"), iroot(n - 1, 3));
+  EXPECT_EQ(big_integer("-999999999999999999999999999999"), iroot(1 - n, 3));
+  EXPECT_EQ(big_integer("1000000000000000000"), iroot(n, 5));
+  EXPECT_EQ(10, iroot(n, 90));
+  EXPECT_EQ(1, iroot(n, 300));
+  EXPECT_EQ(1, iroot(1000, 4000000000));
+  EXPECT_EQ(-1, iroot(-1000, 4000000001));
+  EXPECT_EQ(0, iroot(0, 4000000000));
+  EXPECT_EQ(3, iroot((big_integer(1) << 100000) - 1, 50000));
+  EXPECT_EQ(4, iroot(big_integer(1) << 100000, 50000));
+  EXPECT_EQ(1, iroot((big_integer(1) << 100000) - 1, 100000));
+  EXPECT_EQ(2, iroot(big_integer(1) << 100000, 100000));
+  EXPECT_EQ(n, iroot(n, 1));
+
+  EXPECT_THROW(iroot(n, 0), std::invalid_argument);
+  EXPECT_THROW(iroot(-n, 2), std::invalid_argument);
+}
+
+TEST(correctness, divmod_) {
+  for (int a : {7, -7, 6, -6, 0}) {
+    for (int b : {3, -3, 1}) {
+      auto [q, r] = divmod(a, b);
+      EXPECT_EQ(a / b, q);
+      EXPECT_EQ(a % b, r);
+
+      int floor_q = a / b - (a % b != 0 && (a < 0) != (b < 0));
+      auto [fq, fr] = divmod(a, b, division_rounding::floor);
+      EXPECT_EQ(floor_q, fq);
+      EXPECT_EQ(a - floor_q * b, fr);
+    }
+  }
+
+  big_integer a = -(big_integer(1) << 3000) + 12345;
+  big_integer b = (big_integer(1) << 1000) + 1;
+  big_integer q, r;
+  divmod(a, b, q, r, division_rounding::floor);
+  EXPECT_EQ(a / b - 1, q);
+  EXPECT_EQ(a % b + b, r);
+
+  big_integer x = a;
+  big_integer y = b;
+  divmod(x, y, y, x);
+  EXPECT_EQ(a / b, y);
+  EXPECT_EQ(a % b, x);
+
+  EXPECT_THROW(divmod(a, 0), std::runtime_error);
+}
+
 TEST(correctness, div_int_min) {
   big_integer a = std::numeric_limits<int>::min();
   EXPECT_TRUE((a / a) == (a / std::numeric_limits<int>::min()));
@@ -489,6 +939,25 @@ TEST(correctness, not_) {
   EXPECT_TRUE(~a == (-a - 1));
 }
 
+TEST(correctness, bitwise_long_signed) {
+  big_integer a("-4294967295");
+  big_integer b("-4294967294");
+  big_integer c("-340282366920938463463374607431768211455");
+
+  EXPECT_EQ(a & b, big_integer("-4294967296"));
+  EXPECT_EQ(c & a, big_integer("-340282366920938463463374607431768211455"));
+  EXPECT_EQ(a | c, big_integer("-4294967295"));
+  EXPECT_EQ(a ^ c, big_integer("340282366920938463463374607427473244160"));
+  EXPECT_EQ(a & 0xffff, 1);
+  EXPECT_EQ(~c, big_integer("340282366920938463463374607431768211454"));
+  EXPECT_EQ(~big_integer("18446744073709551615"), big_integer("-18446744073709551616"));
+
+  a &= a;
+  EXPECT_EQ(a, big_integer("-4294967295"));
+  a ^= a;
+  EXPECT_EQ(a, 0);
+}
+
 TEST(correctness, shl_) {
   big_integer a = 23;
 
@@ -534,6 +1003,28 @@ TEST(correctness, shr_signed) {
   EXPECT_EQ(-155, a);
 }
 
+TEST(correctness, shr_long_signed) {
+  big_integer a = -(big_integer(1) << 100);
+
+  EXPECT_EQ(-(big_integer(1) << 36), a >> 64);
+  EXPECT_EQ(-(big_integer(1) << 36) - 1, (a - 1) >> 64);
+  EXPECT_EQ(-1, a >> 101);
+  EXPECT_EQ(-1, a >> 1000);
+  EXPECT_EQ(0, -a >> 1000);
+}
+
+TEST(correctness, shift_size_t) {
+  big_integer a = -12345;
+  size_t bits = 100003;
+
+  shift_left(a, bits);
+  EXPECT_EQ(-12345 * (big_integer(1) << 100003), a);
+  shift_right(a, bits - 3);
+  EXPECT_EQ(-98760, a);
+  shift_right(a, bits);
+  EXPECT_EQ(-1, a);
+}
+
 TEST(correctness, shr_return_value) {
   big_integer a = 64;
 
@@ -637,6 +1128,81 @@ TEST(correctness, mul_long_pow2) {
   EXPECT_EQ(c, b * b);
 }
 
+TEST(correctness, mul_karatsuba) {
+  big_integer a = (big_integer(1) << 40000) - 1;
+  big_integer b = (big_integer(1) << 40000) + 1;
+
+  EXPECT_EQ((big_integer(1) << 80000) - 1, a * b);
+  EXPECT_EQ(-((big_integer(1) << 80000) - 1), -a * b);
+}
+
+TEST(correctness, mul_karatsuba_unbalanced) {
+  big_integer a = 1;
+  big_integer b = -1;
+  for (int i = 0; i < 1500; i++) {
+    a *= 1000000007;
+    if (i % 3 == 0) {
+      b *= 998244353;
+    }
+  }
+  big_integer c = a + 12345;
+
+  EXPECT_EQ(a * b, b * a);
+  EXPECT_EQ(a * b + a * c, a * (b + c));
+  EXPECT_EQ(a * c + b * c, (a + b) * c);
+  EXPECT_EQ(a, a * b / b);
+}
+
+TEST(correctness, mul_toom_cook) {
+  big_integer a = 1;
+  big_integer b = 1;
+  for (int i = 0; i < 2000; i++) {
+    a *= 1000000007;
+    if (i < 1700) {
+      b *= -998244353;
+    }
+  }
+  b -= 1;
+  big_integer c = a - (b << 1000);
+
+  EXPECT_EQ(a * b, b * a);
+  EXPECT_EQ(a * b + a * c, a * (b + c));
+  EXPECT_EQ(b * c - a * c, (b - a) * c);
+  EXPECT_EQ(b, a * b / a);
+}
+
+TEST(correctness, mul_ntt) {
+  big_integer a = (big_integer(1) << 800000) - 1;
+
+  EXPECT_EQ((big_integer(1) << 1600000) - (big_integer(1) << 800001) + 1, a * a);
+
+  big_integer b = pow(big_integer(1000000007), 14000);
+  big_integer c = (b << 1000) - 987654321;
+  big_integer b_low = b & ((big_integer(1) << 80000) - 1);
+  big_integer b_high = b >> 80000;
+
+  EXPECT_EQ(b, (b_high << 80000) + b_low);
+  EXPECT_EQ((b_high * c << 80000) + b_low * c, b * c);
+}
+
+TEST(correctness, sqr_) {
+  big_integer a = -1;
+  for (int i = 0; i < 3000; i++) {
+    a *= 1000000007 - i;
+    if (i % 250 == 0) {
+      big_integer b = a;
+      big_integer c = a;
+      c *= c;
+
+      EXPECT_EQ(a * b, sqr(a));
+      EXPECT_EQ(a * b, a * a);
+      EXPECT_EQ(a * b, c);
+    }
+  }
+  EXPECT_EQ(0, sqr(big_integer()));
+  EXPECT_EQ(1, sqr(big_integer(-1)));
+}
+
 TEST(correctness, div_0_long) {
   big_integer a;
   big_integer b("100000000000000000000000000000000000000000000000000000000000");
@@ -670,6 +1236,53 @@ TEST(correctness, div_long_signed2) {
   EXPECT_EQ(c, a / b);
 }
 
+TEST(correctness, div_recursive) {
+  big_integer x = 1;
+  big_integer y = -1;
+  for (int i = 0; i < 4000; i++) {
+    x *= 1000000007 + i;
+    if (i % 2 == 0) {
+      y *= 998244353 - i;
+    }
+  }
+  big_integer r = y / 3 + 12345;
+  big_integer a = x * y + r;
+
+  EXPECT_EQ(x, a / y);
+  EXPECT_EQ(-x, a / -y);
+  EXPECT_EQ(r, a % -y);
+  EXPECT_EQ(r, (a - x * y * y) % y);
+  EXPECT_EQ(y, (a - r) / x);
+  EXPECT_EQ(0, (a - r) % x);
+  EXPECT_EQ(1, y / y);
+}
+
+TEST(correctness, reciprocal_) {
+  big_integer d = 1;
+  for (int i = 0; i < 1000; i++) {
+    d *= 1000000007 + i;
+  }
+  big_reciprocal reciprocal(d);
+  big_reciprocal negative_reciprocal(-d);
+
+  EXPECT_EQ(d, reciprocal.divisor());
+  EXPECT_EQ(0, reciprocal.divide(d - 1));
+  EXPECT_EQ(1, reciprocal.divide(d));
+  EXPECT_EQ(-1, negative_reciprocal.divide(d));
+
+  big_integer a = -12345;
+  for (int i = 0; i < 5; i++) {
+    a = a * d * 3 + d / 7;
+    EXPECT_EQ(a / d, reciprocal.divide(a));
+    EXPECT_EQ(a % d, reciprocal.remainder(a));
+    EXPECT_EQ(a / -d, negative_reciprocal.divide(a));
+    EXPECT_EQ(a % -d, negative_reciprocal.remainder(a));
+  }
+  EXPECT_EQ(0, big_reciprocal(7).divide(6));
+  EXPECT_EQ(-3, big_reciprocal(7).remainder(-17));
+  EXPECT_THROW(big_reciprocal(0), std::runtime_error);
+}
+
 TEST(correctness, negation_long) {
   big_integer a("10000000000000000000000000000000000000000000000000000");
   big_integer c("-10000000000000000000000000000000000000000000000000000");
@@ -718,6 +1331,41 @@ TEST(correctness, string_conv) {
   EXPECT_EQ("-2147483649", to_string(lim));
 }
 
+TEST(correctness, string_conv_long) {
+  big_integer power = 1;
+  for (int i = 0; i < 5000; i++) {
+    power *= 1000000000;
+  }
+  std::string nines(45000, '9');
+
+  EXPECT_EQ("1" + std::string(45000, '0'), to_string(power));
+  EXPECT_EQ(nines, to_string(power - 1));
+  EXPECT_EQ("-" + nines, to_string(1 - power));
+  EXPECT_EQ("-1" + std::string(44998, '0') + "1", to_string(-power / 10 - 1));
+
+  big_integer a = -1;
+  for (int i = 0; i < 3000; i++) {
+    a *= 1000000007 + i;
+  }
+  EXPECT_EQ(a, big_integer(to_string(a)));
+  EXPECT_EQ(to_string(a), to_string(big_integer(to_string(a))));
+}
+
+TEST(correctness, string_parse_long) {
+  std::string digits = "-000" + std::string(30000, '0') + "1" + std::string(29999, '9');
+  std::string_view view = digits;
+  big_integer a(view);
+  big_integer power = 1;
+  for (int i = 0; i < 9999; i++) {
+    power *= 1000;
+  }
+  power *= 100;
+  EXPECT_EQ(1 - 2 * power, a);
+  EXPECT_EQ(big_integer(view.substr(1, 100)), 0);
+  EXPECT_EQ(big_integer(view.substr(30003)), power * 2 - 1);
+  EXPECT_THROW(big_integer(std::string(view.substr(0, 5)) + std::string(100, '1') + "x"), std::invalid_argument);
+}
+
 namespace {
 template <typename T>
 void test_converting_ctor(T value) {